@@ -2,32 +2,351 @@ from typing import Optional
 
 import esphome.codegen as cg
 import esphome.config_validation as cv
+import esphome.final_validate as fv
+from esphome import automation
 from esphome.components import uart
-from esphome.const import CONF_ID
+from esphome.const import (CONF_ID, CONF_INTERVAL, CONF_KEY, CONF_PLATFORM,
+                           CONF_TRIGGER_ID, CONF_UART_ID)
+from esphome.helpers import fnv1_hash
 
 CODEOWNERS = ["@mill1000"]
 DEPENDENCIES = ["uart"]
 
 MULTI_CONF = True
 CONF_WINIX_C545_ID = "winix_c545_id"
+CONF_MAX_SENTENCES_PER_LOOP = "max_sentences_per_loop"
+CONF_MAX_LOOP_TIME = "max_loop_time"
+CONF_COMMAND_COALESCE_WINDOW = "command_coalesce_window"
+CONF_COMMAND_TIMEOUT = "command_timeout"
+CONF_COMMAND_RETRIES = "command_retries"
+CONF_TX_INTERVAL = "tx_interval"
+CONF_LOG_PROTOCOL = "log_protocol"
+CONF_DEVICE_READY_TIMEOUT = "device_ready_timeout"
+CONF_HANDSHAKE_TIMEOUT = "handshake_timeout"
+CONF_HANDSHAKE_MAX_BACKOFF = "handshake_max_backoff"
+CONF_RESUME_HANDSHAKE = "resume_handshake"
+CONF_RESTORE_STATE = "restore_state"
+CONF_APPLY_RESTORED_STATE = "apply_restored_state"
+CONF_RESTORE_SAVE_DELAY = "restore_save_delay"
+CONF_CAPTURE_BUFFER_SIZE = "capture_buffer_size"
+CONF_MAX_LINE_LENGTH = "max_line_length"
+CONF_AQI_CONTROL = "aqi_control"
+CONF_THRESHOLDS = "thresholds"
+CONF_HYSTERESIS = "hysteresis"
+CONF_MIN_DWELL = "min_dwell"
+CONF_OVERRIDE_TIMEOUT = "override_timeout"
+CONF_KEYS = "keys"
+CONF_LINK_TIMEOUT = "link_timeout"
+CONF_TELEMETRY = "telemetry"
+CONF_ON_FRAME = "on_frame"
+
+# Keys handled by built-in entities
+BUILTIN_KEYS = ["A02", "A03", "A04", "A07", "A21", "P01", "S07", "S08", "S14"]
+WRITABLE_BUILTIN_KEYS = ["A02", "A03", "A04", "A07"]
+
+# Must match MAX_CUSTOM_KEYS in protocol.h
+MAX_CUSTOM_KEYS = 16
+
+LOG_PROTOCOL_LEVELS = {
+    "none": 0,
+    "errors": 1,
+    "summary": 2,
+    "full": 3,
+}
+
+
+def validate_key(value):
+    """Validate a 3 character protocol key which is not built-in."""
+    value = cv.string_strict(value).upper()
+    if len(value) != 3 or not value.isalnum():
+        raise cv.Invalid("Key must be 3 alphanumeric characters, e.g. A05")
+    if value in BUILTIN_KEYS:
+        raise cv.Invalid(
+            f"Key {value} is already handled by a built-in entity")
+    return value
+
+
+def validate_writable_key(value):
+    """Validate a 3 character protocol key which can be written."""
+    value = cv.string_strict(value).upper()
+    if value in WRITABLE_BUILTIN_KEYS:
+        return value
+    return validate_key(value)
+
+
+def validate_unique_keys(value):
+    """Validate each entry of a list of custom entities has a unique key."""
+    keys = [conf[CONF_KEY] for conf in value]
+    for key in keys:
+        if keys.count(key) > 1:
+            raise cv.Invalid(f"Key {key} is defined more than once")
+    return value
+
+
+def validate_thresholds(value):
+    """Validate AQI control thresholds are increasing."""
+    if value != sorted(set(value)):
+        raise cv.Invalid("Thresholds must be increasing")
+    return value
+
+
+def validate_link_timeout(value):
+    """Validate the link timeout is disabled or long enough for handshake."""
+    value = cv.positive_time_period_milliseconds(value)
+    if 0 < value.total_milliseconds < 5000:
+        raise cv.Invalid("Link timeout must be 0s to disable or at least 5s")
+    return value
+
+
+AQI_CONTROL_SCHEMA = cv.Schema(
+    {
+        # AQI at which Medium, High and Turbo speeds are selected
+        cv.Required(CONF_THRESHOLDS): cv.All(
+            cv.ensure_list(cv.uint16_t),
+            cv.Length(min=1, max=3),
+            validate_thresholds,
+        ),
+        cv.Optional(CONF_HYSTERESIS, default=5): cv.uint16_t,
+        cv.Optional(CONF_MIN_DWELL, default="60s"):
+            cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_OVERRIDE_TIMEOUT, default="30min"):
+            cv.positive_time_period_milliseconds,
+    }
+)
 
 winix_c545_ns = cg.esphome_ns.namespace("winix_c545")
 WinixC545Component = winix_c545_ns.class_(
-    "WinixC545Component", uart.UARTDevice, cg.Component)
+    "WinixC545Component", uart.UARTDevice, cg.PollingComponent)
+RefreshAction = winix_c545_ns.class_("RefreshAction", automation.Action)
+DumpCaptureAction = winix_c545_ns.class_(
+    "DumpCaptureAction", automation.Action)
+ReplayCaptureAction = winix_c545_ns.class_(
+    "ReplayCaptureAction", automation.Action)
+WriteKeysAction = winix_c545_ns.class_("WriteKeysAction", automation.Action)
+# Telemetry frames are passed to automations as data and length
+TelemetryFramePtr = cg.uint8.operator("const").operator("ptr")
+TelemetryTrigger = winix_c545_ns.class_(
+    "TelemetryTrigger",
+    automation.Trigger.template(TelemetryFramePtr, cg.size_t))
+
+TELEMETRY_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_INTERVAL, default="60s"):
+            cv.All(cv.positive_time_period_milliseconds,
+                   cv.Range(min=cv.TimePeriod(seconds=1))),
+        cv.Required(CONF_ON_FRAME): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID):
+                    cv.declare_id(TelemetryTrigger),
+            }
+        ),
+    }
+)
 
 CONFIG_SCHEMA = (
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(WinixC545Component),
+            cv.Optional(CONF_MAX_SENTENCES_PER_LOOP, default=8):
+                cv.int_range(min=1, max=255),
+            cv.Optional(CONF_MAX_LOOP_TIME, default="10ms"):
+                cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_COMMAND_COALESCE_WINDOW, default="50ms"):
+                cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_COMMAND_TIMEOUT, default="1s"):
+                cv.All(cv.positive_time_period_milliseconds,
+                       cv.Range(min=cv.TimePeriod(milliseconds=100))),
+            cv.Optional(CONF_COMMAND_RETRIES, default=2):
+                cv.int_range(min=0, max=8),
+            cv.Optional(CONF_TX_INTERVAL, default="20ms"):
+                cv.All(cv.positive_time_period_milliseconds,
+                       cv.Range(max=cv.TimePeriod(seconds=1))),
+            cv.Optional(CONF_LOG_PROTOCOL, default="full"):
+                cv.enum(LOG_PROTOCOL_LEVELS, lower=True),
+            cv.Optional(CONF_DEVICE_READY_TIMEOUT, default="5s"):
+                cv.All(cv.positive_time_period_milliseconds,
+                       cv.Range(min=cv.TimePeriod(milliseconds=100))),
+            cv.Optional(CONF_HANDSHAKE_TIMEOUT, default="3s"):
+                cv.All(cv.positive_time_period_milliseconds,
+                       cv.Range(min=cv.TimePeriod(milliseconds=100))),
+            cv.Optional(CONF_HANDSHAKE_MAX_BACKOFF, default="60s"):
+                cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_RESUME_HANDSHAKE, default=True): cv.boolean,
+            cv.Optional(CONF_RESTORE_STATE, default=True): cv.boolean,
+            cv.Optional(CONF_APPLY_RESTORED_STATE, default=False): cv.boolean,
+            cv.Optional(CONF_RESTORE_SAVE_DELAY, default="60s"):
+                cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_CAPTURE_BUFFER_SIZE, default=0):
+                cv.Any(cv.one_of(0), cv.int_range(min=64, max=65536)),
+            cv.Optional(CONF_MAX_LINE_LENGTH, default=128):
+                cv.int_range(min=128, max=4096),
+            cv.Optional(CONF_AQI_CONTROL): AQI_CONTROL_SCHEMA,
+            cv.Optional(CONF_LINK_TIMEOUT, default="0s"):
+                validate_link_timeout,
+            cv.Optional(CONF_TELEMETRY): TELEMETRY_SCHEMA,
         }
     )
     .extend(uart.UART_DEVICE_SCHEMA)
-    .extend(cv.COMPONENT_SCHEMA)
+    .extend(cv.polling_component_schema("never"))
 )
 
 
+def _writable_keys(full_config, instance_id):
+    """Find the keys which can be written to an instance."""
+    keys = set(WRITABLE_BUILTIN_KEYS)
+    for domain in ("number", "select", "switch"):
+        for conf in full_config.get(domain, []):
+            if (conf[CONF_PLATFORM] != "winix_c545"
+                    or conf[CONF_WINIX_C545_ID].id != instance_id):
+                continue
+            if CONF_KEY in conf:
+                keys.add(conf[CONF_KEY])
+            keys.update(custom[CONF_KEY] for custom in conf.get("custom", []))
+    return keys
+
+
+def _write_keys_actions(value):
+    """Find the configuration of every write_keys action."""
+    if isinstance(value, dict):
+        for key, item in value.items():
+            if key == "winix_c545.write_keys":
+                yield item
+            else:
+                yield from _write_keys_actions(item)
+    elif isinstance(value, list):
+        for item in value:
+            yield from _write_keys_actions(item)
+
+
+def _final_validate(config):
+    # Protocol log level is a compile time define shared by all instances
+    full_config = fv.full_config.get()
+    levels = {conf[CONF_LOG_PROTOCOL] for conf in full_config["winix_c545"]}
+    if len(levels) > 1:
+        raise cv.Invalid(
+            f"{CONF_LOG_PROTOCOL} must be the same for all winix_c545 "
+            "instances")
+
+    # Several purifiers are supported with one instance per UART
+    uart_ids = [conf[CONF_UART_ID].id for conf in full_config["winix_c545"]]
+    if uart_ids.count(config[CONF_UART_ID].id) > 1:
+        raise cv.Invalid(
+            f"UART {config[CONF_UART_ID].id} is used by more than one "
+            "winix_c545 instance")
+
+    # Each instance controls a single fan
+    fans = [
+        conf for conf in full_config.get("fan", [])
+        if conf[CONF_PLATFORM] == "winix_c545"
+        and conf[CONF_WINIX_C545_ID].id == config[CONF_ID].id
+    ]
+    if len(fans) > 1:
+        raise cv.Invalid(
+            f"winix_c545 instance {config[CONF_ID].id} has more than one fan")
+
+    # Keys which are not writable would be dropped when the action runs
+    writable = _writable_keys(full_config, config[CONF_ID].id)
+    for action in _write_keys_actions(full_config):
+        if action[CONF_ID].id != config[CONF_ID].id:
+            continue
+        for key in action[CONF_KEYS]:
+            if key not in writable:
+                raise cv.Invalid(
+                    f"Key {key} written by winix_c545.write_keys must be "
+                    "built-in or bound to a number, select or custom switch "
+                    f"of winix_c545 instance {config[CONF_ID].id}")
+
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
+
+
 async def to_code(config) -> None:
     var = cg.new_Pvariable(config[CONF_ID])
 
     await cg.register_component(var, config)
     await uart.register_uart_device(var, config)
+
+    cg.add(var.set_max_sentences_per_loop(
+        config[CONF_MAX_SENTENCES_PER_LOOP]))
+    cg.add(var.set_max_loop_time(config[CONF_MAX_LOOP_TIME]))
+    cg.add(var.set_command_coalesce_window(
+        config[CONF_COMMAND_COALESCE_WINDOW]))
+    cg.add(var.set_command_timeout(config[CONF_COMMAND_TIMEOUT]))
+    cg.add(var.set_command_retries(config[CONF_COMMAND_RETRIES]))
+    cg.add(var.set_tx_interval(config[CONF_TX_INTERVAL]))
+
+    cg.add(var.set_device_ready_timeout(config[CONF_DEVICE_READY_TIMEOUT]))
+    cg.add(var.set_handshake_timeout(config[CONF_HANDSHAKE_TIMEOUT]))
+    cg.add(var.set_handshake_max_backoff(config[CONF_HANDSHAKE_MAX_BACKOFF]))
+    cg.add(var.set_resume_handshake(config[CONF_RESUME_HANDSHAKE]))
+    cg.add(var.set_restore_state(config[CONF_RESTORE_STATE]))
+    cg.add(var.set_apply_restored_state(config[CONF_APPLY_RESTORED_STATE]))
+    cg.add(var.set_restore_save_delay(config[CONF_RESTORE_SAVE_DELAY]))
+    cg.add(var.set_capture_buffer_size(config[CONF_CAPTURE_BUFFER_SIZE]))
+    cg.add(var.set_max_line_length(config[CONF_MAX_LINE_LENGTH]))
+    cg.add(var.set_link_timeout(config[CONF_LINK_TIMEOUT]))
+
+    if aqi_control := config.get(CONF_AQI_CONTROL):
+        for threshold in aqi_control[CONF_THRESHOLDS]:
+            cg.add(var.add_aqi_control_threshold(threshold))
+        cg.add(var.set_aqi_control_hysteresis(aqi_control[CONF_HYSTERESIS]))
+        cg.add(var.set_aqi_control_min_dwell(aqi_control[CONF_MIN_DWELL]))
+        cg.add(var.set_aqi_control_override_timeout(
+            aqi_control[CONF_OVERRIDE_TIMEOUT]))
+
+    if telemetry := config.get(CONF_TELEMETRY):
+        cg.add(var.set_telemetry_interval(telemetry[CONF_INTERVAL]))
+        for conf in telemetry[CONF_ON_FRAME]:
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+            await automation.build_automation(
+                trigger,
+                [(TelemetryFramePtr, "data"), (cg.size_t, "length")],
+                conf)
+
+    # Unique preference key for each instance
+    cg.add(var.set_preference_hash(fnv1_hash(config[CONF_ID].id)))
+
+    cg.add_define("WINIX_C545_LOG_PROTOCOL",
+                  LOG_PROTOCOL_LEVELS[config[CONF_LOG_PROTOCOL]])
+
+
+WINIX_C545_ACTION_SCHEMA = automation.maybe_simple_id(
+    {
+        cv.GenerateID(): cv.use_id(WinixC545Component),
+    }
+)
+
+
+@automation.register_action(
+    "winix_c545.refresh", RefreshAction, WINIX_C545_ACTION_SCHEMA)
+@automation.register_action(
+    "winix_c545.dump_capture", DumpCaptureAction, WINIX_C545_ACTION_SCHEMA)
+@automation.register_action(
+    "winix_c545.replay_capture", ReplayCaptureAction, WINIX_C545_ACTION_SCHEMA)
+async def action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+WRITE_KEYS_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(WinixC545Component),
+        cv.Required(CONF_KEYS): cv.All(
+            cv.Schema({validate_writable_key: cv.uint16_t}),
+            cv.Length(min=1, max=8),
+        ),
+    }
+)
+
+
+@automation.register_action(
+    "winix_c545.write_keys", WriteKeysAction, WRITE_KEYS_SCHEMA)
+async def write_keys_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    for key, value in config[CONF_KEYS].items():
+        cg.add(var.add_key(key, value))
+    return var
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "winix_c545.h"
+
+namespace esphome {
+namespace winix_c545 {
+
+template <typename... Ts>
+class RefreshAction : public Action<Ts...>, public Parented<WinixC545Component> {
+ public:
+  void play(Ts... x) override { this->parent_->request_refresh(); }
+};
+
+template <typename... Ts>
+class DumpCaptureAction : public Action<Ts...>, public Parented<WinixC545Component> {
+ public:
+  void play(Ts... x) override { this->parent_->dump_capture(); }
+};
+
+template <typename... Ts>
+class ReplayCaptureAction : public Action<Ts...>, public Parented<WinixC545Component> {
+ public:
+  void play(Ts... x) override { this->parent_->replay_capture(); }
+};
+
+template <typename... Ts>
+class WriteKeysAction : public Action<Ts...>, public Parented<WinixC545Component> {
+ public:
+  static constexpr size_t MAX_KEYS = 8;
+
+  void add_key(const char *name, uint16_t value) {
+    if (this->count_ < MAX_KEYS)
+      this->keys_[this->count_++] = {name, value};
+  }
+
+  void play(Ts... x) override {
+    // All keys are queued together and sent in a single A211 command
+    WinixStateMap states;
+    for (size_t i = 0; i < this->count_; i++)
+      this->parent_->set_key_state(states, this->keys_[i].name, this->keys_[i].value);
+
+    this->parent_->write_state(states);
+  }
+
+ protected:
+  struct KeyValue {
+    const char *name;
+    uint16_t value;
+  };
+
+  KeyValue keys_[MAX_KEYS]{};
+  size_t count_{0};
+};
+
+class TelemetryTrigger : public Trigger<const uint8_t *, size_t> {
+ public:
+  explicit TelemetryTrigger(WinixC545Component *parent) {
+    parent->add_on_telemetry_callback([this](const uint8_t *data, size_t length) { this->trigger(data, length); });
+  }
+};
+
+}  // namespace winix_c545
+}  // namespace esphome
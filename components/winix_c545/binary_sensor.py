@@ -0,0 +1,50 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+import esphome.final_validate as fv
+from esphome.components import binary_sensor
+from esphome.const import (CONF_ID, DEVICE_CLASS_CONNECTIVITY,
+                           ENTITY_CATEGORY_DIAGNOSTIC)
+
+from . import CONF_LINK_TIMEOUT, CONF_WINIX_C545_ID, WinixC545Component
+
+DEPENDENCIES = ["winix_c545"]
+
+CONF_LINK = "link"
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_WINIX_C545_ID): cv.use_id(WinixC545Component),
+        cv.Optional(CONF_LINK): binary_sensor.binary_sensor_schema(
+            device_class=DEVICE_CLASS_CONNECTIVITY,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    }
+)
+
+
+def _final_validate(config):
+    # The link only goes down when the watchdog is enabled
+    if CONF_LINK not in config:
+        return config
+
+    full_config = fv.full_config.get()
+    for conf in full_config["winix_c545"]:
+        if conf[CONF_ID].id != config[CONF_WINIX_C545_ID].id:
+            continue
+        if conf[CONF_LINK_TIMEOUT].total_milliseconds == 0:
+            raise cv.Invalid(
+                f"{CONF_LINK} requires {CONF_LINK_TIMEOUT} to be set on "
+                f"winix_c545 instance {conf[CONF_ID].id}")
+
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
+
+
+async def to_code(config) -> None:
+    component = await cg.get_variable(config[CONF_WINIX_C545_ID])
+
+    if sensor_config := config.get(CONF_LINK):
+        sens = await binary_sensor.new_binary_sensor(sensor_config)
+        cg.add(component.set_link_binary_sensor(sens))
@@ -0,0 +1,47 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import number
+from esphome.const import CONF_KEY, CONF_MAX_VALUE, CONF_MIN_VALUE, CONF_STEP
+
+from . import (CONF_WINIX_C545_ID, WinixC545Component, validate_writable_key,
+               winix_c545_ns)
+
+DEPENDENCIES = ["winix_c545"]
+
+WinixC545Number = winix_c545_ns.class_("WinixC545Number", number.Number)
+
+
+def validate_range(config):
+    """Validate the minimum value is below the maximum value."""
+    if config[CONF_MIN_VALUE] >= config[CONF_MAX_VALUE]:
+        raise cv.Invalid(
+            f"{CONF_MIN_VALUE} must be less than {CONF_MAX_VALUE}")
+    return config
+
+
+CONFIG_SCHEMA = cv.All(
+    number.number_schema(WinixC545Number).extend(
+        {
+            cv.GenerateID(CONF_WINIX_C545_ID):
+                cv.use_id(WinixC545Component),
+            cv.Required(CONF_KEY): validate_writable_key,
+            cv.Optional(CONF_MIN_VALUE, default=0): cv.uint16_t,
+            cv.Optional(CONF_MAX_VALUE, default=255): cv.uint16_t,
+            cv.Optional(CONF_STEP, default=1): cv.int_range(min=1),
+        }
+    ),
+    validate_range,
+)
+
+
+async def to_code(config) -> None:
+    var = await number.new_number(
+        config,
+        min_value=config[CONF_MIN_VALUE],
+        max_value=config[CONF_MAX_VALUE],
+        step=config[CONF_STEP],
+    )
+    await cg.register_parented(var, config[CONF_WINIX_C545_ID])
+
+    component = await cg.get_variable(config[CONF_WINIX_C545_ID])
+    cg.add(component.add_key_entity(config[CONF_KEY], var))
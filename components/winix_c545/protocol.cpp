@@ -0,0 +1,353 @@
+#include "protocol.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace winix_c545 {
+
+// Commands recognised following the RX prefix
+static constexpr struct {
+  const char *name;
+  SentenceType type;
+} COMMANDS[] = {
+    {"AWS_SEND", SentenceType::AwsSend},
+    {"DEVICEREADY", SentenceType::DeviceReady},
+    {"MCU_READY", SentenceType::McuReady},
+    {"MIB", SentenceType::MIB},
+    {"SETMIB", SentenceType::SetMIB},
+    {"SMODE", SentenceType::SMode},
+};
+
+static constexpr size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+static constexpr uint8_t ALL_COMMANDS = (1 << COMMAND_COUNT) - 1;
+
+void WinixStreamParser::reset_() {
+  this->length_ = 0;
+  this->arguments_offset_ = RX_PREFIX_LENGTH;
+  this->state_ = State::Prefix;
+  this->type_ = SentenceType::Invalid;
+  this->candidates_ = 0;
+  this->complete_ = false;
+  this->overflow_ = false;
+}
+
+void WinixStreamParser::end_command_() {
+  // The command ends at the current position, select the candidate of exactly this length
+  const size_t position = this->length_ - RX_PREFIX_LENGTH;
+  this->type_ = SentenceType::Unknown;
+  for (size_t i = 0; i < COMMAND_COUNT; i++) {
+    if ((this->candidates_ & (1 << i)) && COMMANDS[i].name[position] == '\0')
+      this->type_ = COMMANDS[i].type;
+  }
+
+  this->arguments_offset_ = this->length_;
+  this->state_ = State::Body;
+}
+
+size_t WinixStreamParser::feed(const uint8_t *data, size_t length) {
+  // Previous sentence has been handled, start a new one
+  if (this->complete_)
+    this->reset_();
+
+  for (size_t i = 0; i < length; i++) {
+    const char c = data[i];
+
+    // Ignore new-lines
+    if (c == '\n')
+      continue;
+
+    // Sentence ends on CR
+    if (c == '\r') {
+      if (this->state_ == State::Command)
+        this->end_command_();
+
+      // Discard lines which did not fit in the buffer
+      if (this->overflow_) {
+        this->overflow_count_++;
+        this->reset_();
+        continue;
+      }
+
+      this->storage_[this->length_] = '\0';
+      this->complete_ = true;
+      return i + 1;
+    }
+
+    if (this->overflow_)
+      continue;
+
+    // Keep room for the null terminator
+    if (this->length_ >= this->capacity_ - 1) {
+      this->overflow_ = true;
+      continue;
+    }
+
+    switch (this->state_) {
+      case State::Prefix:
+        if (c != RX_PREFIX[this->length_]) {
+          // Not a valid sentence, keep the line for logging
+          this->state_ = State::Body;
+        } else if (this->length_ + 1 == RX_PREFIX_LENGTH) {
+          this->state_ = State::Command;
+          this->candidates_ = ALL_COMMANDS;
+        }
+        break;
+
+      case State::Command:
+        if ((c >= 'A' && c <= 'Z') || c == '_') {
+          // Drop candidates which don't match at this position
+          const size_t position = this->length_ - RX_PREFIX_LENGTH;
+          for (size_t j = 0; j < COMMAND_COUNT; j++) {
+            if ((this->candidates_ & (1 << j)) && COMMANDS[j].name[position] != c)
+              this->candidates_ &= ~(1 << j);
+          }
+        } else {
+          this->end_command_();
+        }
+        break;
+
+      case State::Body:
+        break;
+    }
+
+    this->storage_[this->length_++] = c;
+  }
+
+  return length;
+}
+
+bool WinixTxQueue::push(TxPriority priority, const char *sentence) {
+  if (this->size_ == CAPACITY)
+    return false;
+
+  // Insert after all sentences of the same or higher priority
+  size_t position = this->size_;
+  while (position > 0 && this->entries_[position - 1].priority > priority) {
+    this->entries_[position] = this->entries_[position - 1];
+    position--;
+  }
+
+  this->entries_[position] = {sentence, priority};
+  this->size_++;
+  return true;
+}
+
+void WinixTxQueue::pop() {
+  if (this->size_ == 0)
+    return;
+
+  this->size_--;
+  memmove(this->entries_, this->entries_ + 1, this->size_ * sizeof(Entry));
+}
+
+bool WinixTxQueue::contains(TxPriority priority) const {
+  for (size_t i = 0; i < this->size_; i++) {
+    if (this->entries_[i].priority == priority)
+      return true;
+  }
+
+  return false;
+}
+
+void WinixCaptureBuffer::push(Direction direction, uint32_t timestamp, const char *data, size_t length) {
+  if (this->storage_ == nullptr)
+    return;
+
+  // Clamp record to the length field and the storage
+  length = std::min<size_t>(length, UINT8_MAX);
+  if (sizeof(Header) + length > this->capacity_)
+    length = this->capacity_ - sizeof(Header);
+
+  // Make room by dropping the oldest records
+  const size_t record_size = sizeof(Header) + length;
+  while (this->capacity_ - this->used_ < record_size)
+    this->evict_();
+
+  Header header{timestamp, direction, static_cast<uint8_t>(length)};
+  size_t position = (this->head_ + this->used_) % this->capacity_;
+  this->write_(position, &header, sizeof(header));
+  position = (position + sizeof(header)) % this->capacity_;
+  this->write_(position, data, length);
+
+  this->used_ += record_size;
+  this->count_++;
+}
+
+void WinixCaptureBuffer::evict_() {
+  Header header;
+  this->read_(this->head_, &header, sizeof(header));
+
+  const size_t record_size = sizeof(header) + header.length;
+  this->head_ = (this->head_ + record_size) % this->capacity_;
+  this->used_ -= record_size;
+  this->count_--;
+}
+
+void WinixCaptureBuffer::read_(size_t position, void *dest, size_t length) const {
+  // Copy in up to two parts to handle wrapping
+  const size_t first = std::min(length, this->capacity_ - position);
+  memcpy(dest, this->storage_ + position, first);
+  memcpy(static_cast<uint8_t *>(dest) + first, this->storage_, length - first);
+}
+
+void WinixCaptureBuffer::write_(size_t position, const void *src, size_t length) {
+  // Copy in up to two parts to handle wrapping
+  const size_t first = std::min(length, this->capacity_ - position);
+  memcpy(this->storage_ + position, src, first);
+  memcpy(this->storage_, static_cast<const uint8_t *>(src) + first, length - first);
+}
+
+void WinixRollingStats::allocate(size_t window) {
+  this->window_ = window;
+  this->values_ = new uint16_t[window];
+  this->min_deque_ = {new uint32_t[window], 0, 0};
+  this->max_deque_ = {new uint32_t[window], 0, 0};
+}
+
+void WinixRollingStats::push_monotonic_(Deque &deque, uint16_t value, bool minimum) {
+  // Drop samples which can no longer be the min or max while the new sample is in the window
+  while (deque.size != 0) {
+    const uint16_t back = this->value_(deque.back(this->window_));
+    if (minimum ? back < value : back > value)
+      break;
+    deque.size--;
+  }
+
+  deque.push_back(this->window_, this->sequence_);
+}
+
+void WinixRollingStats::push(uint16_t value) {
+  if (this->window_ == 0)
+    return;
+
+  // Evict the oldest sample before its slot is reused
+  if (this->count_ == this->window_) {
+    const uint32_t oldest = this->sequence_ - this->window_;
+    this->sum_ -= this->value_(oldest);
+    this->count_--;
+
+    if (this->min_deque_.front() == oldest)
+      this->min_deque_.pop_front(this->window_);
+    if (this->max_deque_.front() == oldest)
+      this->max_deque_.pop_front(this->window_);
+  }
+
+  this->values_[this->sequence_ % this->window_] = value;
+  this->push_monotonic_(this->min_deque_, value, true);
+  this->push_monotonic_(this->max_deque_, value, false);
+
+  this->sum_ += value;
+  this->ema_ = this->count_ == 0 ? value : this->ema_ + this->ema_alpha_ * (value - this->ema_);
+  this->count_++;
+  this->sequence_++;
+}
+
+float WinixRollingStats::slope() const {
+  if (this->count_ < 2)
+    return 0;
+
+  const uint16_t newest = this->value_(this->sequence_ - 1);
+  const uint16_t oldest = this->value_(this->sequence_ - this->count_);
+  return (static_cast<float>(newest) - oldest) / (this->count_ - 1);
+}
+
+constexpr uint8_t WinixSpeedController::LEVEL_VALUES[];
+
+uint8_t WinixSpeedController::target_level(uint16_t aqi, uint8_t current) const {
+  uint8_t level = std::min<uint8_t>(std::max<uint8_t>(current, 1), this->threshold_count_ + 1);
+
+  // Rise once the threshold of the next level is reached
+  while (level <= this->threshold_count_ && aqi >= this->thresholds_[level - 1])
+    level++;
+
+  // Fall once clear of the threshold of the current level by the hysteresis
+  while (level > 1 && aqi + this->hysteresis_ < this->thresholds_[level - 2])
+    level--;
+
+  return level;
+}
+
+uint8_t WinixSpeedController::level_from_value(uint16_t value) {
+  for (size_t i = 0; i < MAX_LEVELS; i++) {
+    if (LEVEL_VALUES[i] == value)
+      return i + 1;
+  }
+
+  return 0;
+}
+
+bool lookup_key(uint32_t packed_key, StateKey &key) {
+  // Binary search of the sorted descriptor table
+  size_t low = 0;
+  size_t high = BUILTIN_KEY_COUNT;
+  while (low < high) {
+    const size_t mid = (low + high) / 2;
+    const uint32_t mid_key = KEY_DESCRIPTORS[mid].packed_key;
+    if (mid_key == packed_key) {
+      key = KEY_DESCRIPTORS[mid].key;
+      return true;
+    }
+
+    if (mid_key < packed_key)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  return false;
+}
+
+const char *key_name(StateKey key) {
+  if (is_custom_key(key))
+    return "???";
+
+  return KEY_DESCRIPTORS[static_cast<size_t>(key)].name;
+}
+
+bool is_writable_builtin_key(StateKey key) { return !is_custom_key(key) && KEY_DESCRIPTORS[static_cast<size_t>(key)].writable; }
+
+// Write little-endian values, independent of host byte order and struct packing
+static uint8_t *put_u16(uint8_t *out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+  return out + 2;
+}
+
+static uint8_t *put_u32(uint8_t *out, uint32_t value) {
+  out = put_u16(out, value & 0xFFFF);
+  return put_u16(out, value >> 16);
+}
+
+size_t encode_telemetry_frame(uint8_t *frame, const WinixStateMap &states, uint16_t sequence, uint32_t timestamp, uint8_t flags) {
+  uint16_t values[STATE_KEY_COUNT]{};
+  uint32_t mask = 0;
+  for (const auto state : states) {
+    values[static_cast<size_t>(state.key)] = state.value;
+    mask |= 1UL << static_cast<size_t>(state.key);
+  }
+
+  uint8_t *out = frame;
+  *out++ = TELEMETRY_FRAME_VERSION;
+  *out++ = flags;
+  out = put_u16(out, sequence);
+  out = put_u32(out, timestamp);
+  out = put_u32(out, mask);
+  for (size_t i = 0; i < STATE_KEY_COUNT; i++)
+    out = put_u16(out, values[i]);
+
+  return out - frame;
+}
+
+uint32_t payload_hash(const char *payload) {
+  // FNV-1a
+  uint32_t hash = 2166136261UL;
+  while (*payload != '\0') {
+    hash ^= static_cast<uint8_t>(*payload++);
+    hash *= 16777619UL;
+  }
+
+  return hash;
+}
+
+}  // namespace winix_c545
+}  // namespace esphome
@@ -0,0 +1,451 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Protocol definitions without ESPHome dependencies, so they can be built for the host
+
+namespace esphome {
+namespace winix_c545 {
+
+// Control keys
+static constexpr char KEY_POWER[] = "A02";
+static constexpr char KEY_AUTO[] = "A03";
+static constexpr char KEY_SPEED[] = "A04";
+static constexpr char KEY_PLASMAWAVE[] = "A07";
+
+// Sensor keys
+static constexpr char KEY_FILTER_AGE[] = "A21";
+static constexpr char KEY_FILTER_LIFETIME[] = "P01";
+static constexpr char KEY_AQI_INDICATOR[] = "S07";
+static constexpr char KEY_AQI[] = "S08";
+static constexpr char KEY_LIGHT[] = "S14";
+
+// Pack a 3 character key into an integer for fast comparison
+static constexpr uint32_t pack_key(const char *key) {
+  return (uint32_t(key[0]) << 16) | (uint32_t(key[1]) << 8) | uint32_t(key[2]);
+}
+
+enum class StateKey {
+  // Control keys
+  Power,
+  Auto,
+  Speed,
+  Plasmawave,
+
+  // Sensor keys
+  FilterAge,
+  FilterLifetime,
+  AQIIndicator,
+  AQI,
+  Light,
+
+  // First of the keys defined in configuration
+  Custom,
+};
+
+// Number of built-in keys in StateKey, must be updated if keys are added
+static constexpr size_t BUILTIN_KEY_COUNT = static_cast<size_t>(StateKey::Custom);
+
+// Maximum number of keys defined in configuration
+static constexpr size_t MAX_CUSTOM_KEYS = 16;
+
+// Number of keys in StateKey, including keys defined in configuration
+static constexpr size_t STATE_KEY_COUNT = BUILTIN_KEY_COUNT + MAX_CUSTOM_KEYS;
+
+// Describes a built-in key
+struct KeyDescriptor {
+  uint32_t packed_key;
+  const char *name;
+  StateKey key;
+  bool writable;
+};
+
+// Built-in keys, in StateKey order which is also sorted by packed key
+static constexpr KeyDescriptor KEY_DESCRIPTORS[] = {
+    {pack_key(KEY_POWER), KEY_POWER, StateKey::Power, true},
+    {pack_key(KEY_AUTO), KEY_AUTO, StateKey::Auto, true},
+    {pack_key(KEY_SPEED), KEY_SPEED, StateKey::Speed, true},
+    {pack_key(KEY_PLASMAWAVE), KEY_PLASMAWAVE, StateKey::Plasmawave, true},
+    {pack_key(KEY_FILTER_AGE), KEY_FILTER_AGE, StateKey::FilterAge, false},
+    {pack_key(KEY_FILTER_LIFETIME), KEY_FILTER_LIFETIME, StateKey::FilterLifetime, false},
+    {pack_key(KEY_AQI_INDICATOR), KEY_AQI_INDICATOR, StateKey::AQIIndicator, false},
+    {pack_key(KEY_AQI), KEY_AQI, StateKey::AQI, false},
+    {pack_key(KEY_LIGHT), KEY_LIGHT, StateKey::Light, false},
+};
+
+// Check the descriptor table can be indexed by StateKey and binary searched by packed key
+static constexpr bool key_descriptors_valid(size_t i = 0) {
+  return i == BUILTIN_KEY_COUNT || (static_cast<size_t>(KEY_DESCRIPTORS[i].key) == i && (i == 0 || KEY_DESCRIPTORS[i - 1].packed_key < KEY_DESCRIPTORS[i].packed_key) && key_descriptors_valid(i + 1));
+}
+
+static_assert(sizeof(KEY_DESCRIPTORS) / sizeof(KEY_DESCRIPTORS[0]) == BUILTIN_KEY_COUNT, "Key descriptor missing");
+static_assert(key_descriptors_valid(), "Key descriptors must be in StateKey order and sorted by packed key");
+
+// Number of built-in keys which can be written
+static constexpr size_t writable_builtin_key_count(size_t i = 0) {
+  return i == BUILTIN_KEY_COUNT ? 0 : (KEY_DESCRIPTORS[i].writable ? 1 : 0) + writable_builtin_key_count(i + 1);
+}
+
+static constexpr bool is_custom_key(StateKey key) { return static_cast<size_t>(key) >= BUILTIN_KEY_COUNT; }
+
+// Index of a key defined in configuration
+static constexpr size_t custom_key_index(StateKey key) { return static_cast<size_t>(key) - BUILTIN_KEY_COUNT; }
+
+// Fixed-size map of device states indexed by StateKey
+class WinixStateMap {
+ public:
+  struct Entry {
+    StateKey key;
+    uint16_t value;
+  };
+
+  // Iterates the keys which have been set, in StateKey order
+  class Iterator {
+   public:
+    Iterator(const WinixStateMap *map, uint32_t mask) : map_(map), mask_(mask) {}
+
+    Entry operator*() const {
+      const uint8_t index = __builtin_ctz(this->mask_);
+      return {static_cast<StateKey>(index), this->map_->values_[index]};
+    }
+
+    Iterator &operator++() {
+      // Clear lowest set bit
+      this->mask_ &= this->mask_ - 1;
+      return *this;
+    }
+
+    bool operator!=(const Iterator &other) const { return this->mask_ != other.mask_; }
+
+   protected:
+    const WinixStateMap *map_;
+    uint32_t mask_;
+  };
+
+  // Set the value of a key, overwriting any existing value
+  void set(StateKey key, uint16_t value) {
+    this->values_[index_(key)] = value;
+    this->mask_ |= bit_(key);
+  }
+
+  // Set the value of a key only if it is not already set
+  bool emplace(StateKey key, uint16_t value) {
+    if (this->has(key))
+      return false;
+
+    this->set(key, value);
+    return true;
+  }
+
+  void erase(StateKey key) { this->mask_ &= ~bit_(key); }
+
+  bool has(StateKey key) const { return (this->mask_ & bit_(key)) != 0; }
+  uint16_t get(StateKey key) const { return this->values_[index_(key)]; }
+
+  bool empty() const { return this->mask_ == 0; }
+  size_t size() const { return __builtin_popcount(this->mask_); }
+  void clear() { this->mask_ = 0; }
+
+  Iterator begin() const { return Iterator(this, this->mask_); }
+  Iterator end() const { return Iterator(this, 0); }
+
+ protected:
+  static_assert(STATE_KEY_COUNT <= 32, "StateKey count exceeds mask size");
+
+  static constexpr size_t index_(StateKey key) { return static_cast<size_t>(key); }
+  static constexpr uint32_t bit_(StateKey key) { return 1UL << index_(key); }
+
+  uint16_t values_[STATE_KEY_COUNT]{};
+  uint32_t mask_{0};
+};
+
+// Compact snapshot of all states for bulk telemetry, in a fixed little-endian layout:
+//    0  uint8   Format version
+//    1  uint8   Flags, see TELEMETRY_FLAG_*
+//    2  uint16  Sequence number, incremented with each frame
+//    4  uint32  Timestamp in milliseconds since boot
+//    8  uint32  Mask of keys with a value, bit N is StateKey N
+//   12  uint16  Value of each StateKey in order, 0 if the key has no value
+static constexpr uint8_t TELEMETRY_FRAME_VERSION = 1;
+static constexpr size_t TELEMETRY_HEADER_SIZE = 12;
+static constexpr size_t TELEMETRY_FRAME_SIZE = TELEMETRY_HEADER_SIZE + 2 * STATE_KEY_COUNT;
+
+// Handshake with the MCU is complete
+static constexpr uint8_t TELEMETRY_FLAG_CONNECTED = 1 << 0;
+
+// Encode a telemetry frame, returns the frame size
+size_t encode_telemetry_frame(uint8_t *frame, const WinixStateMap &states, uint16_t sequence, uint32_t timestamp, uint8_t flags);
+
+// Prefix of sentences received from and sent to the MCU
+static constexpr char RX_PREFIX[] = "AT*ICT*";
+static constexpr size_t RX_PREFIX_LENGTH = sizeof(RX_PREFIX) - 1;
+static constexpr char TX_PREFIX[] = "*ICT*";
+static constexpr size_t TX_PREFIX_LENGTH = sizeof(TX_PREFIX) - 1;
+
+// Sentence types, recognised from the command following the RX prefix
+enum class SentenceType : uint8_t {
+  Invalid,  // Missing RX prefix
+  Unknown,
+  AwsSend,
+  DeviceReady,
+  McuReady,
+  MIB,
+  SetMIB,
+  SMode,
+};
+
+// Incremental parser of CR terminated sentences. The prefix and command are recognised as bytes arrive
+class WinixStreamParser {
+ public:
+  static constexpr size_t DEFAULT_MAX_LINE_LENGTH = 128;
+
+  // Use larger storage for lines, capacity includes the null terminator
+  void set_storage(char *storage, size_t capacity) {
+    this->storage_ = storage;
+    this->capacity_ = capacity;
+    this->reset_();
+  }
+
+  size_t get_capacity() const { return this->capacity_; }
+
+  // Consume bytes up to the end of a sentence, returns the number of bytes consumed.
+  // A complete sentence is available until the next call
+  size_t feed(const uint8_t *data, size_t length);
+
+  bool complete() const { return this->complete_; }
+  SentenceType type() const { return this->type_; }
+
+  // Complete null terminated line, including the prefix
+  char *line() { return this->storage_; }
+  size_t length() const { return this->length_; }
+
+  // Line following the prefix, and following the command
+  char *command() { return this->storage_ + RX_PREFIX_LENGTH; }
+  char *arguments() { return this->storage_ + this->arguments_offset_; }
+
+  uint32_t get_overflow_count() const { return this->overflow_count_; }
+
+ protected:
+  enum class State : uint8_t {
+    Prefix,
+    Command,
+    Body,
+  };
+
+  void reset_();
+  void end_command_();
+
+  char default_storage_[DEFAULT_MAX_LINE_LENGTH];
+  char *storage_{default_storage_};
+  size_t capacity_{DEFAULT_MAX_LINE_LENGTH};
+  size_t length_{0};
+  size_t arguments_offset_{0};
+
+  State state_{State::Prefix};
+  SentenceType type_{SentenceType::Invalid};
+  uint8_t candidates_{0};  // Bitmask of commands matching so far
+  bool complete_{false};
+  bool overflow_{false};
+  uint32_t overflow_count_{0};
+};
+
+// Priority of sentences waiting to be sent, lower values are sent first
+enum class TxPriority : uint8_t {
+  Protocol,  // Acknowledgements and handshake replies
+  Command,   // A211 commands
+  Refresh,   // State refresh requests
+};
+
+// Fixed-capacity queue of sentences waiting to be sent, ordered by priority and then by age.
+// Sentences are not copied and must remain valid until sent
+class WinixTxQueue {
+ public:
+  static constexpr size_t CAPACITY = 8;
+
+  struct Entry {
+    const char *sentence;
+    TxPriority priority;
+  };
+
+  // Queue a sentence behind others of the same priority, returns false if full
+  bool push(TxPriority priority, const char *sentence);
+
+  // Highest priority sentence, only valid if not empty
+  const Entry &front() const { return this->entries_[0]; }
+  void pop();
+
+  bool contains(TxPriority priority) const;
+  bool empty() const { return this->size_ == 0; }
+  size_t size() const { return this->size_; }
+
+ protected:
+  // Kept sorted so the front is the next sentence to send
+  Entry entries_[CAPACITY]{};
+  uint8_t size_{0};
+};
+
+// Fixed-size ring of timestamped lines, oldest records are evicted when full
+class WinixCaptureBuffer {
+ public:
+  enum class Direction : uint8_t {
+    RX,
+    TX,
+  };
+
+  // Record header, followed by the line data
+  struct Header {
+    uint32_t timestamp;
+    Direction direction;
+    uint8_t length;
+  };
+
+  // Set the storage used for records, capacity must exceed the header size
+  void set_storage(uint8_t *storage, size_t capacity) {
+    this->storage_ = storage;
+    this->capacity_ = capacity;
+    this->clear();
+  }
+
+  bool enabled() const { return this->storage_ != nullptr; }
+
+  // Add a record, lines longer than 255 bytes are truncated
+  void push(Direction direction, uint32_t timestamp, const char *data, size_t length);
+
+  void clear() {
+    this->head_ = 0;
+    this->used_ = 0;
+    this->count_ = 0;
+  }
+
+  size_t size() const { return this->count_; }
+
+  // Visit records oldest first. Data is copied to a null terminated buffer
+  template <typename F>
+  void for_each(F &&callback) const {
+    char line[UINT8_MAX + 1];
+    size_t position = this->head_;
+    for (size_t i = 0; i < this->count_; i++) {
+      Header header;
+      this->read_(position, &header, sizeof(header));
+      position = (position + sizeof(header)) % this->capacity_;
+
+      this->read_(position, line, header.length);
+      position = (position + header.length) % this->capacity_;
+      line[header.length] = '\0';
+
+      callback(header, line);
+    }
+  }
+
+ protected:
+  void read_(size_t position, void *dest, size_t length) const;
+  void write_(size_t position, const void *src, size_t length);
+  void evict_();
+
+  uint8_t *storage_{nullptr};
+  size_t capacity_{0};
+  size_t head_{0};  // Offset of oldest record
+  size_t used_{0};  // Bytes used by all records
+  size_t count_{0};
+};
+
+// Rolling statistics over a fixed window of samples, each sample is processed in O(1)
+class WinixRollingStats {
+ public:
+  // Allocate storage for the window, called once at setup
+  void allocate(size_t window);
+  void set_ema_alpha(float alpha) { this->ema_alpha_ = alpha; }
+
+  bool enabled() const { return this->window_ != 0; }
+
+  void push(uint16_t value);
+
+  // Number of samples in the window
+  size_t size() const { return this->count_; }
+  bool empty() const { return this->count_ == 0; }
+
+  // Statistics of the samples in the window, only valid when not empty
+  float mean() const { return static_cast<float>(this->sum_) / this->count_; }
+  uint16_t min() const { return this->value_(this->min_deque_.front()); }
+  uint16_t max() const { return this->value_(this->max_deque_.front()); }
+  float ema() const { return this->ema_; }
+  // Change from the oldest to the newest sample, per sample
+  float slope() const;
+
+ protected:
+  // Ring of sample sequence numbers with values in monotonic order
+  struct Deque {
+    uint32_t *storage;
+    size_t head;
+    size_t size;
+
+    uint32_t front() const { return this->storage[this->head]; }
+    uint32_t back(size_t window) const { return this->storage[(this->head + this->size - 1) % window]; }
+    void pop_front(size_t window) {
+      this->head = (this->head + 1) % window;
+      this->size--;
+    }
+    void push_back(size_t window, uint32_t sequence) { this->storage[(this->head + this->size++) % window] = sequence; }
+  };
+
+  uint16_t value_(uint32_t sequence) const { return this->values_[sequence % this->window_]; }
+  void push_monotonic_(Deque &deque, uint16_t value, bool minimum);
+
+  size_t window_{0};
+  uint16_t *values_{nullptr};
+  Deque min_deque_{};
+  Deque max_deque_{};
+
+  uint32_t sequence_{0};  // Sequence number of the next sample
+  size_t count_{0};
+  uint32_t sum_{0};
+  float ema_{0};
+  float ema_alpha_{0.1f};
+};
+
+// Maps AQI to a manual speed level using rising thresholds with hysteresis
+class WinixSpeedController {
+ public:
+  static constexpr size_t MAX_LEVELS = 4;
+
+  // Add the AQI at which the next speed level is selected, thresholds must be increasing
+  void add_threshold(uint16_t threshold) {
+    if (this->threshold_count_ < MAX_LEVELS - 1)
+      this->thresholds_[this->threshold_count_++] = threshold;
+  }
+  void set_hysteresis(uint16_t hysteresis) { this->hysteresis_ = hysteresis; }
+
+  bool enabled() const { return this->threshold_count_ != 0; }
+
+  // Level for an AQI, starting from the current level so small changes around a threshold are ignored
+  uint8_t target_level(uint16_t aqi, uint8_t current) const;
+
+  // Convert between levels, counted from 1, and device speed values. Returns 0 if not a manual speed
+  static uint8_t level_from_value(uint16_t value);
+  static uint8_t value_from_level(uint8_t level) { return LEVEL_VALUES[level - 1]; }
+
+ protected:
+  // Device speed values of Low, Medium, High and Turbo
+  static constexpr uint8_t LEVEL_VALUES[MAX_LEVELS] = {1, 2, 3, 5};
+
+  uint16_t thresholds_[MAX_LEVELS - 1]{};
+  size_t threshold_count_{0};
+  uint16_t hysteresis_{0};
+};
+
+// Map a packed key to a built-in StateKey, returns false if the key is not built-in
+bool lookup_key(uint32_t packed_key, StateKey &key);
+
+// Protocol string for a built-in StateKey
+const char *key_name(StateKey key);
+
+// True if a built-in StateKey can be written. Out of line so the descriptor table is only emitted once
+bool is_writable_builtin_key(StateKey key);
+
+// Hash of a null terminated payload, for change detection
+uint32_t payload_hash(const char *payload);
+
+}  // namespace winix_c545
+}  // namespace esphome
@@ -0,0 +1,46 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import select
+from esphome.const import CONF_KEY, CONF_OPTIONS
+
+from . import (CONF_WINIX_C545_ID, WinixC545Component, validate_writable_key,
+               winix_c545_ns)
+
+DEPENDENCIES = ["winix_c545"]
+
+WinixC545Select = winix_c545_ns.class_("WinixC545Select", select.Select)
+
+
+def validate_options(value):
+    """Validate each option maps to a distinct key value."""
+    values = list(value.values())
+    if len(values) != len(set(values)):
+        raise cv.Invalid("Option values must be unique")
+    return value
+
+
+CONFIG_SCHEMA = select.select_schema(WinixC545Select).extend(
+    {
+        cv.GenerateID(CONF_WINIX_C545_ID): cv.use_id(WinixC545Component),
+        cv.Required(CONF_KEY): validate_writable_key,
+        # Option names and the key value written for each
+        cv.Required(CONF_OPTIONS): cv.All(
+            cv.Schema({cv.string_strict: cv.uint16_t}),
+            # Must match MAX_OPTIONS in winix_c545.h
+            cv.Length(min=1, max=16),
+            validate_options,
+        ),
+    }
+)
+
+
+async def to_code(config) -> None:
+    options = config[CONF_OPTIONS]
+    var = await select.new_select(config, options=list(options.keys()))
+    await cg.register_parented(var, config[CONF_WINIX_C545_ID])
+
+    for value in options.values():
+        cg.add(var.add_value(value))
+
+    component = await cg.get_variable(config[CONF_WINIX_C545_ID])
+    cg.add(component.add_key_entity(config[CONF_KEY], var))
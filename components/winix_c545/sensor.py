@@ -1,18 +1,155 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import sensor
-from esphome.const import (DEVICE_CLASS_AQI, DEVICE_CLASS_DURATION,
+from esphome.const import (CONF_KEY, CONF_MULTIPLY, CONF_UPDATE_INTERVAL,
+                           DEVICE_CLASS_AQI, DEVICE_CLASS_DURATION,
                            ENTITY_CATEGORY_DIAGNOSTIC, STATE_CLASS_MEASUREMENT,
-                           UNIT_EMPTY, UNIT_HOUR)
+                           STATE_CLASS_TOTAL_INCREASING, UNIT_EMPTY, UNIT_HOUR,
+                           UNIT_MICROSECOND, UNIT_MILLISECOND, UNIT_PERCENT,
+                           UNIT_SECOND)
 
-from . import CONF_WINIX_C545_ID, WinixC545Component
+from . import (CONF_WINIX_C545_ID, MAX_CUSTOM_KEYS, WinixC545Component,
+               validate_key, validate_unique_keys)
 
 DEPENDENCIES = ["winix_c545"]
 
 CONF_AQI = "aqi"
 CONF_FILTER_AGE = "filter_age"
 CONF_FILTER_LIFETIME = "filter_lifetime"
+CONF_FILTER_REMAINING = "filter_remaining"
+CONF_FILTER_ETA = "filter_eta"
 CONF_LIGHT = "light"
+CONF_COMMAND_ACK_LATENCY = "command_ack_latency"
+CONF_COMMAND_RETRY_COUNT = "command_retry_count"
+CONF_COMMAND_FAILURE_COUNT = "command_failure_count"
+
+CONF_CUSTOM = "custom"
+
+CONF_PUBLISH_POLICY = "publish_policy"
+CONF_MIN_INTERVAL = "min_interval"
+CONF_HEARTBEAT = "heartbeat"
+CONF_DELTA = "delta"
+CONF_DELTA_PERCENT = "delta_percent"
+
+CONF_STATISTICS = "statistics"
+CONF_SAMPLE_INTERVAL = "sample_interval"
+CONF_WINDOW_SIZE = "window_size"
+CONF_EMA_ALPHA = "ema_alpha"
+CONF_MEAN = "mean"
+CONF_MIN = "min"
+CONF_MAX = "max"
+CONF_EMA = "ema"
+CONF_RATE = "rate"
+
+STATISTICS_SENSORS = [CONF_MEAN, CONF_MIN, CONF_MAX, CONF_EMA, CONF_RATE]
+
+CONF_DIAGNOSTICS = "diagnostics"
+CONF_RX_SENTENCES = "rx_sentences"
+CONF_TX_SENTENCES = "tx_sentences"
+CONF_PARSE_ERRORS = "parse_errors"
+CONF_UNKNOWN_API_CODES = "unknown_api_codes"
+CONF_LINE_OVERFLOWS = "line_overflows"
+CONF_HANDSHAKE_RESETS = "handshake_resets"
+CONF_TIME_SINCE_STATE = "time_since_state"
+CONF_LOOP_TIME_MAX = "loop_time_max"
+CONF_LOOP_TIME_AVG = "loop_time_avg"
+
+DIAGNOSTIC_COUNTERS = [
+    CONF_RX_SENTENCES,
+    CONF_TX_SENTENCES,
+    CONF_PARSE_ERRORS,
+    CONF_UNKNOWN_API_CODES,
+    CONF_LINE_OVERFLOWS,
+    CONF_HANDSHAKE_RESETS,
+]
+
+
+def counter_schema():
+    return sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=0,
+        icon="mdi:counter",
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    )
+
+
+def loop_time_schema():
+    return sensor.sensor_schema(
+        unit_of_measurement=UNIT_MICROSECOND,
+        accuracy_decimals=0,
+        device_class=DEVICE_CLASS_DURATION,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    )
+
+
+DIAGNOSTICS_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_UPDATE_INTERVAL, default="60s"):
+            cv.All(cv.positive_time_period_milliseconds,
+                   cv.Range(min=cv.TimePeriod(seconds=1))),
+        **{cv.Optional(key): counter_schema() for key in DIAGNOSTIC_COUNTERS},
+        cv.Optional(CONF_TIME_SINCE_STATE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_SECOND,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_DURATION,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_LOOP_TIME_MAX): loop_time_schema(),
+        cv.Optional(CONF_LOOP_TIME_AVG): loop_time_schema(),
+    }
+)
+
+PUBLISH_POLICY_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_MIN_INTERVAL, default="0s"):
+            cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_HEARTBEAT, default="0s"):
+            cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_DELTA, default=0): cv.positive_float,
+        cv.Optional(CONF_DELTA_PERCENT, default="0%"): cv.percentage,
+    }
+)
+
+
+def statistics_schema(**kwargs):
+    return cv.Schema(
+        {
+            cv.Optional(CONF_SAMPLE_INTERVAL, default="10s"):
+                cv.All(cv.positive_time_period_milliseconds,
+                       cv.Range(min=cv.TimePeriod(seconds=1))),
+            cv.Optional(CONF_WINDOW_SIZE, default=30):
+                cv.int_range(min=2, max=1024),
+            cv.Optional(CONF_EMA_ALPHA, default=0.1):
+                cv.float_range(min=0, min_included=False, max=1),
+            **{
+                cv.Optional(key): sensor.sensor_schema(
+                    accuracy_decimals=1,
+                    state_class=STATE_CLASS_MEASUREMENT,
+                    **kwargs,
+                )
+                for key in [CONF_MEAN, CONF_MIN, CONF_MAX, CONF_EMA]
+            },
+            cv.Optional(CONF_RATE): sensor.sensor_schema(
+                unit_of_measurement="/min",
+                accuracy_decimals=2,
+                state_class=STATE_CLASS_MEASUREMENT,
+            ),
+        }
+    )
+
+
+CUSTOM_SENSOR_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+).extend(
+    {
+        cv.Required(CONF_KEY): validate_key,
+        cv.Optional(CONF_MULTIPLY, default=1.0): cv.float_,
+    }
+)
 
 CONFIG_SCHEMA = cv.Schema(
     {
@@ -31,21 +168,91 @@ CONFIG_SCHEMA = cv.Schema(
             state_class=STATE_CLASS_MEASUREMENT,
             entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
         ),
+        cv.Optional(CONF_FILTER_REMAINING): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            accuracy_decimals=0,
+            icon="mdi:air-filter",
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_FILTER_ETA): sensor.sensor_schema(
+            unit_of_measurement=UNIT_HOUR,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_DURATION,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
         cv.Optional(CONF_AQI): sensor.sensor_schema(
             unit_of_measurement=UNIT_EMPTY,
             accuracy_decimals=0,
             device_class=DEVICE_CLASS_AQI,
             state_class=STATE_CLASS_MEASUREMENT,
+        ).extend(
+            {
+                cv.Optional(CONF_PUBLISH_POLICY): PUBLISH_POLICY_SCHEMA,
+                cv.Optional(CONF_STATISTICS): statistics_schema(
+                    unit_of_measurement=UNIT_EMPTY,
+                    device_class=DEVICE_CLASS_AQI,
+                ),
+            }
         ),
         cv.Optional(CONF_LIGHT): sensor.sensor_schema(
             unit_of_measurement=UNIT_EMPTY,
             accuracy_decimals=0,
             state_class=STATE_CLASS_MEASUREMENT,
-        )
+        ).extend(
+            {
+                cv.Optional(CONF_PUBLISH_POLICY): PUBLISH_POLICY_SCHEMA,
+                cv.Optional(CONF_STATISTICS): statistics_schema(
+                    unit_of_measurement=UNIT_EMPTY,
+                ),
+            }
+        ),
+        cv.Optional(CONF_COMMAND_ACK_LATENCY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_DURATION,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_COMMAND_RETRY_COUNT): counter_schema(),
+        cv.Optional(CONF_COMMAND_FAILURE_COUNT): counter_schema(),
+        cv.Optional(CONF_DIAGNOSTICS): DIAGNOSTICS_SCHEMA,
+        cv.Optional(CONF_CUSTOM): cv.All(
+            cv.ensure_list(CUSTOM_SENSOR_SCHEMA),
+            cv.Length(max=MAX_CUSTOM_KEYS),
+            validate_unique_keys,
+        ),
     }
 )
 
 
+def publish_policy_args(config):
+    policy = config.get(CONF_PUBLISH_POLICY, PUBLISH_POLICY_SCHEMA({}))
+    return [
+        policy[CONF_MIN_INTERVAL],
+        policy[CONF_HEARTBEAT],
+        policy[CONF_DELTA],
+        policy[CONF_DELTA_PERCENT],
+    ]
+
+
+async def statistics_args(config):
+    statistics = config[CONF_STATISTICS]
+    sensors = []
+    for key in STATISTICS_SENSORS:
+        if sensor_config := statistics.get(key):
+            sensors.append(await sensor.new_sensor(sensor_config))
+        else:
+            sensors.append(cg.nullptr)
+
+    return [
+        statistics[CONF_SAMPLE_INTERVAL],
+        statistics[CONF_WINDOW_SIZE],
+        statistics[CONF_EMA_ALPHA],
+    ], sensors
+
+
 async def to_code(config) -> None:
     component = await cg.get_variable(config[CONF_WINIX_C545_ID])
 
@@ -57,10 +264,61 @@ async def to_code(config) -> None:
         sens = await sensor.new_sensor(sensor_config)
         cg.add(component.set_filter_lifetime_sensor(sens))
 
+    if sensor_config := config.get(CONF_FILTER_REMAINING):
+        sens = await sensor.new_sensor(sensor_config)
+        cg.add(component.set_filter_remaining_sensor(sens))
+
+    if sensor_config := config.get(CONF_FILTER_ETA):
+        sens = await sensor.new_sensor(sensor_config)
+        cg.add(component.set_filter_eta_sensor(sens))
+
     if sensor_config := config.get(CONF_AQI):
         sens = await sensor.new_sensor(sensor_config)
         cg.add(component.set_aqi_sensor(sens))
+        cg.add(component.set_aqi_publish_policy(
+            *publish_policy_args(sensor_config)))
+
+        if CONF_STATISTICS in sensor_config:
+            args, sensors = await statistics_args(sensor_config)
+            cg.add(component.set_aqi_statistics(*args))
+            cg.add(component.set_aqi_statistics_sensors(*sensors))
 
     if sensor_config := config.get(CONF_LIGHT):
         sens = await sensor.new_sensor(sensor_config)
         cg.add(component.set_light_sensor(sens))
+        cg.add(component.set_light_publish_policy(
+            *publish_policy_args(sensor_config)))
+
+        if CONF_STATISTICS in sensor_config:
+            args, sensors = await statistics_args(sensor_config)
+            cg.add(component.set_light_statistics(*args))
+            cg.add(component.set_light_statistics_sensors(*sensors))
+
+    if sensor_config := config.get(CONF_COMMAND_ACK_LATENCY):
+        sens = await sensor.new_sensor(sensor_config)
+        cg.add(component.set_command_ack_latency_sensor(sens))
+
+    if sensor_config := config.get(CONF_COMMAND_RETRY_COUNT):
+        sens = await sensor.new_sensor(sensor_config)
+        cg.add(component.set_command_retry_count_sensor(sens))
+
+    if sensor_config := config.get(CONF_COMMAND_FAILURE_COUNT):
+        sens = await sensor.new_sensor(sensor_config)
+        cg.add(component.set_command_failure_count_sensor(sens))
+
+    if diagnostics_config := config.get(CONF_DIAGNOSTICS):
+        cg.add(component.set_diagnostics_interval(
+            diagnostics_config[CONF_UPDATE_INTERVAL]))
+
+        for key in DIAGNOSTIC_COUNTERS + [CONF_TIME_SINCE_STATE,
+                                          CONF_LOOP_TIME_MAX,
+                                          CONF_LOOP_TIME_AVG]:
+            if sensor_config := diagnostics_config.get(key):
+                sens = await sensor.new_sensor(sensor_config)
+                cg.add(getattr(component, f"set_{key}_sensor")(sens))
+
+    # Keys not handled by built-in sensors
+    for sensor_config in config.get(CONF_CUSTOM, []):
+        sens = await sensor.new_sensor(sensor_config)
+        cg.add(component.add_custom_sensor(
+            sensor_config[CONF_KEY], sens, sensor_config[CONF_MULTIPLY]))
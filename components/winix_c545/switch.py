@@ -1,16 +1,33 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import switch
-from esphome.const import DEVICE_CLASS_SWITCH
+from esphome.const import CONF_KEY, DEVICE_CLASS_SWITCH
 
-from . import CONF_WINIX_C545_ID, WinixC545Component, winix_c545_ns
+from . import (CONF_WINIX_C545_ID, MAX_CUSTOM_KEYS, WinixC545Component,
+               validate_key, validate_unique_keys, winix_c545_ns)
 
 DEPENDENCIES = ["winix_c545"]
 
 WinixC545PlasmawaveSwitch = winix_c545_ns.class_(
     "WinixC545PlasmawaveSwitch", switch.Switch)
+WinixC545CustomSwitch = winix_c545_ns.class_(
+    "WinixC545CustomSwitch", switch.Switch)
 
 CONF_PLASMAWAVE = "plasmawave"
+CONF_CUSTOM = "custom"
+CONF_ON_VALUE = "on_value"
+CONF_OFF_VALUE = "off_value"
+
+CUSTOM_SWITCH_SCHEMA = switch.switch_schema(
+    WinixC545CustomSwitch,
+    device_class=DEVICE_CLASS_SWITCH,
+).extend(
+    {
+        cv.Required(CONF_KEY): validate_key,
+        cv.Optional(CONF_ON_VALUE, default=1): cv.uint8_t,
+        cv.Optional(CONF_OFF_VALUE, default=0): cv.uint8_t,
+    }
+)
 
 CONFIG_SCHEMA = cv.Schema(
     {
@@ -19,7 +36,12 @@ CONFIG_SCHEMA = cv.Schema(
             WinixC545PlasmawaveSwitch,
             device_class=DEVICE_CLASS_SWITCH,
             icon="mdi:lightning-bolt-outline",
-        )
+        ),
+        cv.Optional(CONF_CUSTOM): cv.All(
+            cv.ensure_list(CUSTOM_SWITCH_SCHEMA),
+            cv.Length(max=MAX_CUSTOM_KEYS),
+            validate_unique_keys,
+        ),
     }
 )
 
@@ -31,3 +53,11 @@ async def to_code(config) -> None:
         sw = await switch.new_switch(switch_config)
         await cg.register_parented(sw, config[CONF_WINIX_C545_ID])
         cg.add(component.set_plasmawave_switch(sw))
+
+    # Keys not handled by built-in switches
+    for switch_config in config.get(CONF_CUSTOM, []):
+        sw = await switch.new_switch(switch_config)
+        await cg.register_parented(sw, config[CONF_WINIX_C545_ID])
+        cg.add(sw.set_values(
+            switch_config[CONF_ON_VALUE], switch_config[CONF_OFF_VALUE]))
+        cg.add(component.add_custom_switch(switch_config[CONF_KEY], sw))
@@ -1,8 +1,8 @@
-
 #include "winix_c545.h"
 
-#include <string>
-#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 
 #include "esphome/core/log.h"
 
@@ -11,77 +11,636 @@ namespace winix_c545 {
 
 static const char *const TAG = "winix_c545";
 
-const std::unordered_map<std::string, StateKey> WinixC545Component::ENUM_KEY_MAP = {
-    {KEY_POWER, StateKey::Power},
-    {KEY_AUTO, StateKey::Auto},
-    {KEY_SPEED, StateKey::Speed},
-    {KEY_PLASMAWAVE, StateKey::Plasmawave},
-
-    {KEY_FILTER_AGE, StateKey::FilterAge},
-    {KEY_FILTER_LIFETIME, StateKey::FilterLifetime},
-    {KEY_AQI_INDICATOR, StateKey::AQIIndicator},
-    {KEY_AQI, StateKey::AQI},
-    {KEY_LIGHT, StateKey::Light},
-};
+// Protocol logging is compiled out below the configured log_protocol level
+#if WINIX_C545_LOG_PROTOCOL >= WINIX_C545_LOG_PROTOCOL_ERRORS
+#define PROTOCOL_LOGE(...) ESP_LOGE(TAG, __VA_ARGS__)
+#define PROTOCOL_LOGW(...) ESP_LOGW(TAG, __VA_ARGS__)
+#else
+#define PROTOCOL_LOGE(...) \
+  do {                     \
+  } while (0)
+#define PROTOCOL_LOGW(...) \
+  do {                     \
+  } while (0)
+#endif
 
-const std::unordered_map<StateKey, std::string> WinixC545Component::STRING_KEY_MAP = {
-    {StateKey::Power, KEY_POWER},
-    {StateKey::Auto, KEY_AUTO},
-    {StateKey::Speed, KEY_SPEED},
-    {StateKey::Plasmawave, KEY_PLASMAWAVE},
-};
+#if WINIX_C545_LOG_PROTOCOL >= WINIX_C545_LOG_PROTOCOL_SUMMARY
+#define PROTOCOL_LOG_SUMMARY(...) ESP_LOGD(TAG, __VA_ARGS__)
+#else
+#define PROTOCOL_LOG_SUMMARY(...) \
+  do {                            \
+  } while (0)
+#endif
+
+#if WINIX_C545_LOG_PROTOCOL >= WINIX_C545_LOG_PROTOCOL_FULL
+#define PROTOCOL_LOG_FULL(...) ESP_LOGD(TAG, __VA_ARGS__)
+#else
+#define PROTOCOL_LOG_FULL(...) \
+  do {                         \
+  } while (0)
+#endif
+
+void WinixC545Component::write_sentence_(const char *sentence) {
+  this->write_sentence_(sentence, strlen(sentence));
+}
+
+void WinixC545Component::write_sentence_(const char *sentence, size_t length) {
+  const size_t prefix_length = TX_PREFIX_LENGTH;
+
+  // Ensure prefix, sentence and CRLF fit in the frame buffer
+  if (prefix_length + length + 2 > sizeof(this->tx_buffer_)) {
+    ESP_LOGE(TAG, "Sentence too long to send: %.*s", (int) length, sentence);
+    return;
+  }
+
+  // Compose the complete frame
+  size_t position = 0;
+  memcpy(this->tx_buffer_, TX_PREFIX, prefix_length);
+  position += prefix_length;
+  memcpy(this->tx_buffer_ + position, sentence, length);
+  position += length;
+
+  PROTOCOL_LOG_FULL("Sending sentence: %.*s", (int) position, this->tx_buffer_);
+
+  if (this->replaying_)
+    return;
+
+  if (this->capture_.enabled())
+    this->capture_.push(WinixCaptureBuffer::Direction::TX, millis(), this->tx_buffer_, position);
+
+  this->tx_buffer_[position++] = '\r';
+  this->tx_buffer_[position++] = '\n';
+
+  // Send over UART in a single write
+  this->write_array(reinterpret_cast<const uint8_t *>(this->tx_buffer_), position);
+  this->stats_.tx_sentences++;
+  this->last_tx_time_ = millis();
+}
+
+void WinixC545Component::queue_sentence_(TxPriority priority, const char *sentence) {
+  // Replayed lines are only logged, nothing is sent
+  if (this->replaying_) {
+    this->write_sentence_(sentence);
+    return;
+  }
 
-void WinixC545Component::write_sentence_(const std::string &sentence) {
-  ESP_LOGD(TAG, "Sending sentence: %s%s", TX_PREFIX.c_str(), sentence.c_str());
+  if (!this->tx_queue_.push(priority, sentence))
+    ESP_LOGW(TAG, "TX queue full, dropping sentence: %s", sentence);
+}
+
+void WinixC545Component::drain_tx_queue_() {
+  while (!this->tx_queue_.empty()) {
+    const WinixTxQueue::Entry entry = this->tx_queue_.front();
+
+    // Pace commands and refreshes so bursts don't overrun the MCU, replies are never delayed
+    if (entry.priority != TxPriority::Protocol && (millis() - this->last_tx_time_) < this->tx_interval_)
+      return;
 
-  // Send over UART
-  this->write_str(TX_PREFIX.c_str());
-  this->write_str(sentence.c_str());
-  this->write_str("\r\n");
+    this->tx_queue_.pop();
+
+    // Commands are composed when sent, so changes made while queued are merged
+    if (entry.priority == TxPriority::Command) {
+      this->write_commands_(this->queued_commands_);
+      this->queued_commands_.clear();
+    } else {
+      this->write_sentence_(entry.sentence);
+    }
+  }
 }
 
 void WinixC545Component::write_state(const WinixStateMap &states) {
-  constexpr uint32_t BUFFER_SIZE = 16;
+  // Changes from entities and actions are manual and pause the AQI controller
+  if (states.has(StateKey::Power) || states.has(StateKey::Auto) || states.has(StateKey::Speed))
+    this->pause_aqi_control_();
 
+  this->queue_commands_(states);
+}
+
+void WinixC545Component::queue_commands_(const WinixStateMap &states) {
   // Nothing to do if empty
   if (states.empty())
     return;
 
-  std::string sentence = "AWS_RECV:A211 12 {";
+  // Start the coalescing window on the first pending command
+  if (this->pending_commands_.empty())
+    this->pending_commands_time_ = millis();
+
+  // Merge into pending commands, later writes to a key replace earlier ones
+  for (const auto state : states) {
+    this->pending_commands_.set(state.key, state.value);
+
+    // Remember commanded state for restore
+    if (this->restore_state_ && is_persisted_key_(state.key)) {
+      this->saved_states_.commanded.set(state.key, state.value);
+      this->mark_saved_states_dirty_();
+    }
+  }
+
+  // Send immediately if coalescing is disabled
+  if (this->command_coalesce_window_ == 0)
+    this->flush_commands_();
+}
+
+void WinixC545Component::pause_aqi_control_() {
+  if (!this->aqi_controller_.enabled())
+    return;
+
+  if (!this->aqi_control_override_)
+    ESP_LOGI(TAG, "AQI control paused by manual change");
+
+  this->aqi_control_override_ = true;
+  this->aqi_control_override_time_ = millis();
+  this->aqi_control_speed_ = 0;
+}
+
+void WinixC545Component::update_aqi_control_() {
+  if (!this->aqi_controller_.enabled() || this->handshake_state_ != HandshakeState::Connected)
+    return;
+
+  // Wait for the command to settle before evaluating again
+  if (this->pending_commands_.has(StateKey::Speed) || this->queued_commands_.has(StateKey::Speed) || this->inflight_commands_.has(StateKey::Speed))
+    return;
+
+  if (!this->device_states_.has(StateKey::Speed) || !this->device_states_.has(StateKey::AQI))
+    return;
+
+  const uint16_t speed = this->device_states_.get(StateKey::Speed);
+
+  // A speed the controller didn't command was set on the device itself
+  if (this->aqi_control_speed_ != 0 && speed != this->aqi_control_speed_)
+    this->pause_aqi_control_();
+
+  const uint32_t now = millis();
+  if (this->aqi_control_override_) {
+    if ((now - this->aqi_control_override_time_) < this->aqi_control_override_timeout_)
+      return;
+
+    ESP_LOGI(TAG, "AQI control resumed");
+    this->aqi_control_override_ = false;
+  }
+
+  // Only control a powered fan at a manual speed, Auto and Sleep are left to the device
+  const bool power = this->device_states_.has(StateKey::Power) && this->device_states_.get(StateKey::Power) == 1;
+  const bool auto_mode = this->device_states_.has(StateKey::Auto) && this->device_states_.get(StateKey::Auto) == 1;
+  const uint8_t level = WinixSpeedController::level_from_value(speed);
+  if (!power || auto_mode || level == 0)
+    return;
+
+  const uint16_t aqi = this->device_states_.get(StateKey::AQI);
+  const uint8_t target = this->aqi_controller_.target_level(aqi, level);
+  if (target == level)
+    return;
+
+  // Limit how often the speed changes
+  if (this->aqi_control_speed_ != 0 && (now - this->aqi_control_change_time_) < this->aqi_control_min_dwell_)
+    return;
+
+  ESP_LOGD(TAG, "AQI control: AQI %u, speed level %u -> %u", aqi, level, target);
 
-  // Reserve storage for each possible state
-  sentence.reserve(states.size() * BUFFER_SIZE);
+  WinixStateMap states;
+  states.set(StateKey::Speed, WinixSpeedController::value_from_level(target));
+  this->queue_commands_(states);
+
+  this->aqi_control_speed_ = WinixSpeedController::value_from_level(target);
+  this->aqi_control_change_time_ = now;
+}
+
+void WinixC545Component::flush_commands_() {
+  // Merge into the queued command, which is sent as a single A211 sentence
+  if (!this->tx_queue_.contains(TxPriority::Command) && !this->tx_queue_.push(TxPriority::Command, nullptr)) {
+    // Queue full, try again on the next loop
+    return;
+  }
+
+  for (const auto state : this->pending_commands_)
+    this->queued_commands_.set(state.key, state.value);
+  this->pending_commands_.clear();
+}
 
-  for (const auto &state : states) {
-    const StateKey key = state.first;
-    const uint16_t value = state.second;
+void WinixC545Component::write_commands_(const WinixStateMap &states) {
+  // Nothing to do if empty
+  if (states.empty())
+    return;
+
+  char sentence[MAX_SENTENCE_LENGTH];
+  size_t length = snprintf(sentence, sizeof(sentence), "AWS_RECV:A211 12 {");
 
-    // Check if key is supported
-    if (STRING_KEY_MAP.count(key) == 0) {
-      ESP_LOGW(TAG, "Unsupported key: %d", key);
+  // Compose the sentence from the supported keys
+  WinixStateMap commands;
+  for (const auto state : states) {
+    const StateKey key = state.key;
+    const uint16_t value = state.value;
+
+    // Check if key can be written
+    if (!this->is_writable_key_(key)) {
+      ESP_LOGW(TAG, "Unsupported key: %s", this->key_name_(key));
       continue;
     }
 
-    char buffer[BUFFER_SIZE];
-    snprintf(buffer, sizeof(buffer), "\"%s\":\"%d\",", STRING_KEY_MAP.at(key).c_str(), value);
+    const int written = snprintf(sentence + length, sizeof(sentence) - length, "\"%s\":\"%u\",", this->key_name_(key), value);
+    if (written < 0 || length + written >= sizeof(sentence)) {
+      ESP_LOGE(TAG, "Command sentence too long");
+      return;
+    }
 
-    sentence.append(buffer);
+    length += written;
+    commands.set(key, value);
   }
 
+  // No supported keys to send
+  if (commands.empty())
+    return;
+
   // Replace final comma with an end brace
-  sentence.at(sentence.size() - 1) = '}';
+  sentence[length - 1] = '}';
+
+  // Track the commands until the MCU reports the requested values
+  const uint32_t now = millis();
+  for (const auto command : commands) {
+    PROTOCOL_LOG_SUMMARY("Command %s set to %u", this->key_name_(command.key), command.value);
+
+    InflightCommand &info = this->inflight_info_[static_cast<size_t>(command.key)];
+    if (this->inflight_commands_.has(command.key) && this->inflight_commands_.get(command.key) == command.value) {
+      // Resending an outstanding command
+      info.attempts++;
+    } else {
+      this->inflight_commands_.set(command.key, command.value);
+      info.attempts = 1;
+      info.first_sent = now;
+      info.has_previous = this->device_states_.has(command.key);
+      info.previous = info.has_previous ? this->device_states_.get(command.key) : 0;
+    }
+    info.last_sent = now;
+  }
 
   // Write sentence to device
-  this->write_sentence_(sentence);
+  this->write_sentence_(sentence, length);
+}
+
+void WinixC545Component::update_inflight_commands_() {
+  for (const auto state : this->states_) {
+    const StateKey key = state.key;
+    const uint16_t value = state.value;
+
+    // Remember reported state for restore
+    if (this->restore_state_ && is_persisted_key_(key) && (!this->saved_states_.observed.has(key) || this->saved_states_.observed.get(key) != value)) {
+      this->saved_states_.observed.set(key, value);
+      this->mark_saved_states_dirty_();
+    }
+
+    if (!this->inflight_commands_.has(key))
+      continue;
+
+    const InflightCommand &info = this->inflight_info_[static_cast<size_t>(key)];
+    if (this->inflight_commands_.get(key) != value) {
+      if (!info.has_previous || value == info.previous) {
+        // Command not applied yet, hold the optimistic state until it is or times out
+        this->states_.erase(key);
+        continue;
+      }
+
+      // Neither the commanded nor the previous value, so changed on the device itself. The
+      // device wins, drop the command so a retry does not overwrite the change
+      ESP_LOGD(TAG, "Key %s changed on device to %u, dropping command", this->key_name_(key), value);
+      const uint16_t command = this->inflight_commands_.get(key);
+      this->inflight_commands_.erase(key);
+
+      // Cancel a queued retry, but not a newer command for the key
+      if (this->pending_commands_.has(key) && this->pending_commands_.get(key) == command)
+        this->pending_commands_.erase(key);
+      if (this->queued_commands_.has(key) && this->queued_commands_.get(key) == command)
+        this->queued_commands_.erase(key);
+      continue;
+    }
+
+    // Command confirmed by MCU
+    const uint32_t latency = millis() - info.first_sent;
+    this->inflight_commands_.erase(key);
+
+    ESP_LOGV(TAG, "Command for key %s acknowledged in %u ms", this->key_name_(key), latency);
+
+#ifdef USE_SENSOR
+    if (this->command_ack_latency_sensor_ != nullptr)
+      this->command_ack_latency_sensor_->publish_state(latency);
+#endif
+  }
+}
+
+void WinixC545Component::check_inflight_timeouts_() {
+  // Nothing to do if empty
+  if (this->inflight_commands_.empty())
+    return;
+
+  const uint32_t now = millis();
+  for (const auto command : this->inflight_commands_) {
+    const StateKey key = command.key;
+    const InflightCommand &info = this->inflight_info_[static_cast<size_t>(key)];
+
+    // Wait with exponential backoff between attempts
+    const uint32_t timeout = this->command_timeout_ << (info.attempts - 1);
+    if ((now - info.last_sent) < timeout)
+      continue;
+
+    // Already queued for resend
+    if (this->pending_commands_.has(key) || this->queued_commands_.has(key))
+      continue;
+
+    // Device already reported the requested value, which does not appear as a change
+    if (this->device_states_.has(key) && this->device_states_.get(key) == command.value) {
+      this->inflight_commands_.erase(key);
+      continue;
+    }
+
+    if (info.attempts <= this->command_retries_) {
+      ESP_LOGW(TAG, "Command for key %s not acknowledged, retrying (%u/%u)", this->key_name_(key), info.attempts, this->command_retries_);
+
+      // Queue the command again
+      if (this->pending_commands_.empty())
+        this->pending_commands_time_ = now;
+      this->pending_commands_.set(key, command.value);
+
+      this->command_retry_count_++;
+#ifdef USE_SENSOR
+      if (this->command_retry_count_sensor_ != nullptr)
+        this->command_retry_count_sensor_->publish_state(this->command_retry_count_);
+#endif
+      continue;
+    }
+
+    ESP_LOGW(TAG, "Command for key %s failed after %u attempts", this->key_name_(key), info.attempts);
+    this->inflight_commands_.erase(key);
+
+    if (this->device_states_.has(key)) {
+      // Revert to the last reported state
+      this->states_.set(key, this->device_states_.get(key));
+    } else if (this->saved_states_.observed.has(key)) {
+      // Not reported since boot, revert to the restored state
+      this->states_.set(key, this->saved_states_.observed.get(key));
+    } else {
+      // No known state to revert to, ask the MCU for its state so the entity is corrected
+      this->request_refresh();
+    }
+
+    this->command_failure_count_++;
+#ifdef USE_SENSOR
+    if (this->command_failure_count_sensor_ != nullptr)
+      this->command_failure_count_sensor_->publish_state(this->command_failure_count_);
+#endif
+  }
+}
+
+#ifdef USE_SENSOR
+bool WinixPublishPolicy::should_publish(uint32_t now) {
+  if (!this->has_value_)
+    return false;
+
+  const uint32_t elapsed = now - this->last_publish_time_;
+  if (this->has_published_) {
+    // Republish periodically regardless of changes
+    bool heartbeat = this->heartbeat_ != 0 && elapsed >= this->heartbeat_;
+    if (!heartbeat) {
+      if (this->value_ == this->published_value_)
+        return false;
+
+      if (elapsed < this->min_interval_)
+        return false;
+
+      const float delta = std::fabs(this->value_ - this->published_value_);
+      if (delta < this->delta_ || delta < this->delta_relative_ * std::fabs(this->published_value_))
+        return false;
+    }
+  }
+
+  this->has_published_ = true;
+  this->published_value_ = this->value_;
+  this->last_publish_time_ = now;
+  return true;
+}
+
+void WinixSensorStatistics::sample(uint16_t value) {
+  this->stats_.push(value);
+
+  if (this->mean_sensor_ != nullptr)
+    this->mean_sensor_->publish_state(this->stats_.mean());
+  if (this->min_sensor_ != nullptr)
+    this->min_sensor_->publish_state(this->stats_.min());
+  if (this->max_sensor_ != nullptr)
+    this->max_sensor_->publish_state(this->stats_.max());
+  if (this->ema_sensor_ != nullptr)
+    this->ema_sensor_->publish_state(this->stats_.ema());
+  if (this->rate_sensor_ != nullptr)
+    this->rate_sensor_->publish_state(this->stats_.slope() * 60000.0f / this->sample_interval_);
+}
+
+void WinixSensorStatistics::dump_config(const char *name) const {
+  if (!this->enabled())
+    return;
+
+  ESP_LOGCONFIG(TAG, "  %s Statistics:", name);
+  ESP_LOGCONFIG(TAG, "    Sample Interval: %u ms", this->sample_interval_);
+  ESP_LOGCONFIG(TAG, "    Window Size: %zu", this->window_size_);
+  LOG_SENSOR("    ", "Mean", this->mean_sensor_);
+  LOG_SENSOR("    ", "Min", this->min_sensor_);
+  LOG_SENSOR("    ", "Max", this->max_sensor_);
+  LOG_SENSOR("    ", "EMA", this->ema_sensor_);
+  LOG_SENSOR("    ", "Rate", this->rate_sensor_);
+}
+
+void WinixC545Component::update_filter_rate_(uint16_t age) {
+  if (this->filter_eta_sensor_ == nullptr)
+    return;
+
+  // Start again on the first report or after a filter reset
+  if (!this->filter_age_seen_ || age < this->filter_age_last_) {
+    this->filter_age_seen_ = true;
+    this->filter_age_last_ = age;
+    this->filter_age_timed_ = false;
+    this->filter_rate_ = 0;
+    return;
+  }
+
+  if (age == this->filter_age_last_)
+    return;
+
+  // Age only increments by whole hours, so the rate is measured between increments.
+  // The first increment only starts timing as the hour before it may be partial
+  const uint32_t now = millis();
+  if (this->filter_age_timed_) {
+    const uint32_t elapsed = std::max<uint32_t>(now - this->filter_age_time_, 1);
+    const float rate = (age - this->filter_age_last_) * 3600000.0f / elapsed;
+    this->filter_rate_ = this->filter_rate_ == 0 ? rate : this->filter_rate_ + FILTER_RATE_SMOOTHING * (rate - this->filter_rate_);
+  }
+
+  this->filter_age_last_ = age;
+  this->filter_age_time_ = now;
+  this->filter_age_timed_ = true;
+}
+
+void WinixC545Component::publish_filter_sensors_() {
+  if (!this->device_states_.has(StateKey::FilterAge) || !this->device_states_.has(StateKey::FilterLifetime))
+    return;
+
+  const uint16_t age = this->device_states_.get(StateKey::FilterAge);
+  const uint16_t lifetime = this->device_states_.get(StateKey::FilterLifetime);
+
+  // Lifetime may be reported as 0 before the MCU has loaded it
+  if (lifetime == 0)
+    return;
+
+  const uint16_t remaining_hours = age < lifetime ? lifetime - age : 0;
+
+  if (this->filter_remaining_sensor_ != nullptr) {
+    const int32_t remaining = std::lround(100.0f * remaining_hours / lifetime);
+    if (remaining != this->filter_remaining_published_) {
+      this->filter_remaining_published_ = remaining;
+      this->filter_remaining_sensor_->publish_state(remaining);
+    }
+  }
+
+  // Wall clock hours until the filter is used up at the current usage rate
+  if (this->filter_eta_sensor_ != nullptr && this->filter_rate_ > 0) {
+    const int32_t eta = std::lround(remaining_hours / this->filter_rate_);
+    if (eta != this->filter_eta_published_) {
+      this->filter_eta_published_ = eta;
+      this->filter_eta_sensor_->publish_state(eta);
+    }
+  }
+}
+
+void WinixC545Component::setup_statistics_(WinixSensorStatistics &statistics, const char *name, StateKey key) {
+  if (!statistics.enabled())
+    return;
+
+  // Sample the latest reported value at a fixed interval, so statistics are weighted by time.
+  // Values are not sampled while disconnected as they may be stale
+  statistics.setup();
+  this->set_interval(name, statistics.get_sample_interval(), [this, &statistics, key]() {
+    if (this->handshake_state_ == HandshakeState::Connected && this->device_states_.has(key))
+      statistics.sample(this->device_states_.get(key));
+  });
+}
+
+void WinixC545Component::publish_policy_sensors_() {
+  const uint32_t now = millis();
+
+  if (this->aqi_sensor_ != nullptr && this->aqi_policy_.should_publish(now))
+    this->aqi_sensor_->publish_state(this->aqi_policy_.get_value());
+
+  if (this->light_sensor_ != nullptr && this->light_policy_.should_publish(now))
+    this->light_sensor_->publish_state(this->light_policy_.get_value());
+}
+#endif
+
+#ifdef USE_SENSOR
+void WinixC545Component::publish_diagnostics_() {
+  if (this->rx_sentences_sensor_ != nullptr)
+    this->rx_sentences_sensor_->publish_state(this->stats_.rx_sentences);
+
+  if (this->tx_sentences_sensor_ != nullptr)
+    this->tx_sentences_sensor_->publish_state(this->stats_.tx_sentences);
+
+  if (this->parse_errors_sensor_ != nullptr)
+    this->parse_errors_sensor_->publish_state(this->stats_.parse_errors);
+
+  if (this->unknown_api_codes_sensor_ != nullptr)
+    this->unknown_api_codes_sensor_->publish_state(this->stats_.unknown_api_codes);
+
+  if (this->line_overflows_sensor_ != nullptr)
+    this->line_overflows_sensor_->publish_state(this->parser_.get_overflow_count());
+
+  if (this->handshake_resets_sensor_ != nullptr)
+    this->handshake_resets_sensor_->publish_state(this->stats_.handshake_resets);
+
+  if (this->time_since_state_sensor_ != nullptr) {
+    if (this->stats_.last_state_time != 0)
+      this->time_since_state_sensor_->publish_state((millis() - this->stats_.last_state_time) / 1000);
+    else
+      this->time_since_state_sensor_->publish_state(NAN);
+  }
+
+  // Loop times are reported over the diagnostics interval
+  if (this->stats_.loop_count != 0) {
+    if (this->loop_time_max_sensor_ != nullptr)
+      this->loop_time_max_sensor_->publish_state(this->stats_.loop_time_max);
+
+    if (this->loop_time_avg_sensor_ != nullptr)
+      this->loop_time_avg_sensor_->publish_state(float(this->stats_.loop_time_total) / this->stats_.loop_count);
+  }
+
+  this->stats_.loop_time_max = 0;
+  this->stats_.loop_time_total = 0;
+  this->stats_.loop_count = 0;
+}
+#endif
+
+bool WinixC545Component::is_persisted_key_(StateKey key) {
+  switch (key) {
+    case StateKey::Power:
+    case StateKey::Auto:
+    case StateKey::Speed:
+    case StateKey::Plasmawave:
+    case StateKey::FilterAge:
+    case StateKey::FilterLifetime:
+      return true;
+
+    default:
+      // Rapidly changing sensor values are not worth the flash wear
+      return false;
+  }
+}
+
+void WinixC545Component::mark_saved_states_dirty_() {
+  // Restart the debounce window on each change
+  this->saved_states_dirty_ = true;
+  this->saved_states_change_time_ = millis();
+}
+
+void WinixC545Component::save_states_() {
+  if (!this->saved_states_dirty_)
+    return;
+
+  // Wait for states to settle before writing
+  if ((millis() - this->saved_states_change_time_) < this->restore_save_delay_)
+    return;
+
+  ESP_LOGD(TAG, "Saving states for restore");
+  this->saved_states_pref_.save(&this->saved_states_);
+  this->saved_states_dirty_ = false;
+}
+
+void WinixC545Component::restore_states_() {
+  // Publish restored states which the MCU has not reported yet
+  for (const auto state : this->saved_states_.observed) {
+    if (!this->device_states_.has(state.key) && !this->states_.has(state.key))
+      this->states_.set(state.key, state.value);
+  }
+
+  this->restore_pending_ = false;
+}
+
+void WinixC545Component::replay_states_() {
+  // Reapply commanded states which differ from what the MCU reports
+  WinixStateMap states;
+  for (const auto state : this->saved_states_.commanded) {
+    if (!this->device_states_.has(state.key) || this->device_states_.get(state.key) != state.value)
+      states.set(state.key, state.value);
+  }
+
+  if (!states.empty())
+    ESP_LOGI(TAG, "Replaying %zu restored commands", states.size());
+
+  // Not a manual change, so AQI control is not paused
+  this->queue_commands_(states);
+  this->replay_pending_ = false;
 }
 
 void WinixC545Component::publish_state_() {
   if (this->states_.empty())
     return;
 
-  for (const auto &state : this->states_) {
-    const StateKey key = state.first;
-    const uint16_t value = state.second;
+  for (const auto state : this->states_) {
+    const StateKey key = state.key;
+    const uint16_t value = state.value;
 
     // Handle sensor states and other non-fan states
     switch (key) {
@@ -118,8 +677,8 @@ void WinixC545Component::publish_state_() {
         if (this->aqi_sensor_ == nullptr)
           continue;
 
-        if (value != this->aqi_sensor_->raw_state)
-          this->aqi_sensor_->publish_state(value);
+        // Published according to policy
+        this->aqi_policy_.set_value(value);
         break;
       }
 
@@ -128,13 +687,15 @@ void WinixC545Component::publish_state_() {
         if (this->light_sensor_ == nullptr)
           continue;
 
-        if (value != this->light_sensor_->raw_state)
-          this->light_sensor_->publish_state(value);
+        // Published according to policy
+        this->light_policy_.set_value(value);
         break;
       }
 
       case StateKey::FilterAge: {
         // Filter age
+        this->update_filter_rate_(value);
+
         if (this->filter_age_sensor_ == nullptr)
           continue;
 
@@ -163,9 +724,28 @@ void WinixC545Component::publish_state_() {
           this->plasmawave_switch_->publish_state(state);
         break;
       }
+
+      default:
+        // Keys defined in configuration
+        if (is_custom_key(key))
+          this->publish_custom_state_(key, value);
+        break;
     }
   }
 
+  // Entities bound to keys by configuration
+  for (size_t i = 0; i < this->key_entity_count_; i++) {
+    WinixKeyEntity *entity = this->key_entities_[i];
+    if (this->states_.has(entity->get_key()))
+      entity->update_value(this->states_.get(entity->get_key()));
+  }
+
+#ifdef USE_SENSOR
+  // Sensors derived from filter age and lifetime
+  if (this->states_.has(StateKey::FilterAge) || this->states_.has(StateKey::FilterLifetime))
+    this->publish_filter_sensors_();
+#endif
+
   // Pass states to underlying fan if it exists
   if (this->fan_ != nullptr) {
     this->fan_->update_state(this->states_);
@@ -173,27 +753,267 @@ void WinixC545Component::publish_state_() {
 
   // All states published, clear contents
   this->states_.clear();
+
+#ifdef USE_SENSOR
+  // Publish sensors allowed by their policy, deferred publishes are handled by a timer
+  this->publish_policy_sensors_();
+#endif
+}
+
+bool WinixC545Component::add_custom_key_(const char *name, bool writable, StateKey &key) {
+  const uint32_t packed_key = pack_key(name);
+
+  if (lookup_key(packed_key, key)) {
+    ESP_LOGE(TAG, "Key %s is built-in and can't be defined in configuration", name);
+    return false;
+  }
+
+  // Reuse an existing registration, e.g. a key with both a sensor and a switch
+  if (this->lookup_key_(packed_key, key)) {
+    this->custom_keys_[custom_key_index(key)].writable |= writable;
+    return true;
+  }
+
+  if (this->custom_key_count_ >= MAX_CUSTOM_KEYS) {
+    ESP_LOGE(TAG, "Too many keys defined in configuration, %s ignored", name);
+    return false;
+  }
+
+  const size_t index = this->custom_key_count_++;
+  CustomKey &custom = this->custom_keys_[index];
+  custom.packed_key = packed_key;
+  memcpy(custom.name, name, 3);
+  custom.name[3] = '\0';
+  custom.writable = writable;
+
+  key = static_cast<StateKey>(BUILTIN_KEY_COUNT + index);
+  return true;
+}
+
+#ifdef USE_SENSOR
+void WinixC545Component::add_custom_sensor(const char *name, sensor::Sensor *sensor, float multiply) {
+  StateKey key;
+  if (!this->add_custom_key_(name, false, key))
+    return;
+
+  CustomKey &custom = this->custom_keys_[custom_key_index(key)];
+  custom.sensor = sensor;
+  custom.multiply = multiply;
+}
+#endif
+
+#ifdef USE_SWITCH
+void WinixC545Component::add_custom_switch(const char *name, WinixC545CustomSwitch *sw) {
+  StateKey key;
+  if (!this->add_custom_key_(name, true, key))
+    return;
+
+  this->custom_keys_[custom_key_index(key)].sw = sw;
+  sw->set_key(key);
+}
+#endif
+
+void WinixC545Component::add_key_entity(const char *name, WinixKeyEntity *entity) {
+  if (this->key_entity_count_ >= MAX_KEY_ENTITIES) {
+    ESP_LOGE(TAG, "Too many key entities, %s ignored", name);
+    return;
+  }
+
+  StateKey key;
+  if (lookup_key(pack_key(name), key)) {
+    // Built-in keys must be writable
+    if (!is_writable_builtin_key(key)) {
+      ESP_LOGE(TAG, "Key %s is read-only", name);
+      return;
+    }
+  } else if (!this->add_custom_key_(name, true, key)) {
+    return;
+  }
+
+  entity->set_key(key);
+  this->key_entities_[this->key_entity_count_++] = entity;
+}
+
+bool WinixC545Component::set_key_state(WinixStateMap &states, const char *name, uint16_t value) const {
+  StateKey key;
+  if (!this->find_key(name, key)) {
+    ESP_LOGW(TAG, "Unknown key: %s", name);
+    return false;
+  }
+
+  states.set(key, value);
+  return true;
+}
+
+bool WinixC545Component::lookup_key_(uint32_t packed_key, StateKey &key) const {
+  if (lookup_key(packed_key, key))
+    return true;
+
+  // Few keys are defined in configuration, a linear search is sufficient
+  for (size_t i = 0; i < this->custom_key_count_; i++) {
+    if (this->custom_keys_[i].packed_key == packed_key) {
+      key = static_cast<StateKey>(BUILTIN_KEY_COUNT + i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const char *WinixC545Component::key_name_(StateKey key) const {
+  if (!is_custom_key(key))
+    return key_name(key);
+
+  const size_t index = custom_key_index(key);
+  if (index >= this->custom_key_count_)
+    return "???";
+
+  return this->custom_keys_[index].name;
+}
+
+bool WinixC545Component::is_writable_key_(StateKey key) const {
+  if (!is_custom_key(key))
+    return is_writable_builtin_key(key);
+
+  const size_t index = custom_key_index(key);
+  return index < this->custom_key_count_ && this->custom_keys_[index].writable;
+}
+
+void WinixC545Component::publish_custom_state_(StateKey key, uint16_t value) {
+  [[maybe_unused]] const CustomKey &custom = this->custom_keys_[custom_key_index(key)];
+
+#ifdef USE_SENSOR
+  if (custom.sensor != nullptr) {
+    const float state = value * custom.multiply;
+    if (state != custom.sensor->raw_state)
+      custom.sensor->publish_state(state);
+  }
+#endif
+
+#ifdef USE_SWITCH
+  if (custom.sw != nullptr) {
+    const bool state = value == custom.sw->get_on_value();
+    if (state != custom.sw->state)
+      custom.sw->publish_state(state);
+  }
+#endif
+}
+
+bool WinixC545Component::parse_payload_(const char *payload) {
+  // Payloads are of the form {"A02":"1","A03":"02",...}
+  // States are only applied once the whole payload is valid, so a malformed payload changes nothing
+  WinixStateMap payload_states;
+  const char *cursor = payload;
+  if (*cursor++ != '{') {
+    PROTOCOL_LOGE("Invalid payload: %s", payload);
+    return false;
+  }
+
+  while (true) {
+    [[maybe_unused]] const char *token = cursor;
+
+    // Key is exactly 3 characters in quotes, followed by the opening quote of the value.
+    // Short-circuit evaluation ensures nothing is read past the null terminator
+    if (!(cursor[0] == '"' && cursor[1] && cursor[2] && cursor[3] && cursor[4] == '"' && cursor[5] == ':' && cursor[6] == '"')) {
+      PROTOCOL_LOGE("Failed to extract from token: %s", token);
+      return false;
+    }
+
+    const uint32_t packed_key = pack_key(cursor + 1);
+    cursor += 7;
+
+    // Decode the decimal value, saturating at the limit of the state storage
+    uint32_t value = 0;
+    const char *digits = cursor;
+    while (*cursor >= '0' && *cursor <= '9') {
+      value = std::min<uint32_t>(value * 10 + (*cursor - '0'), UINT16_MAX);
+      cursor++;
+    }
+
+    bool numeric = cursor != digits && *cursor == '"';
+
+    // Skip any non-numeric value to its closing quote
+    while (*cursor != '"') {
+      if (*cursor == '\0') {
+        PROTOCOL_LOGE("Failed to extract from token: %s", token);
+        return false;
+      }
+      cursor++;
+    }
+    cursor++;
+
+    // Add state if supported
+    StateKey key;
+    if (this->lookup_key_(packed_key, key)) {
+      if (!numeric) {
+        PROTOCOL_LOGE("Failed to extract from token: %s", token);
+        return false;
+      }
+
+      payload_states.set(key, value);
+    }
+
+    if (*cursor == ',') {
+      cursor++;
+      continue;
+    }
+
+    if (*cursor == '}') {
+      // Data following the payload shows the line is corrupt, so none of it is applied
+      if (cursor[1] != '\0') {
+        PROTOCOL_LOGE("Unexpected data after payload: %s", cursor + 1);
+        return false;
+      }
+      break;
+    }
+
+    PROTOCOL_LOGE("Failed to extract from token: %s", token);
+    return false;
+  }
+
+  // Replayed states are logged without changing the live states
+  if (this->replaying_) {
+    for (const auto state : payload_states)
+      PROTOCOL_LOG_SUMMARY("Replayed state %s is %u", this->key_name_(state.key), state.value);
+    return true;
+  }
+
+  // Only dispatch keys which changed since last reported
+  for (const auto state : payload_states) {
+    if (!this->device_states_.has(state.key) || this->device_states_.get(state.key) != state.value) {
+      PROTOCOL_LOG_SUMMARY("State %s changed to %u", this->key_name_(state.key), state.value);
+
+      this->device_states_.set(state.key, state.value);
+      this->states_.set(state.key, state.value);
+    }
+  }
+
+  return true;
 }
 
 void WinixC545Component::parse_aws_sentence_(char *sentence) {
-  uint16_t api_code = 0;
-  if (sscanf(sentence, "AWS_SEND=A%3hu", &api_code) != 1) {
-    ESP_LOGE(TAG, "Failed to extract API code from sentence: %s", sentence);
+  // Decode the 3 digit API code following the command. The stream parser matched the command,
+  // so the offset is within the line and the checks stop at its null terminator
+  const char *code = sentence + strlen("AWS_SEND");
+  if (!(code[0] == '=' && code[1] == 'A' && isdigit(static_cast<unsigned char>(code[2])) && isdigit(static_cast<unsigned char>(code[3])) && isdigit(static_cast<unsigned char>(code[4])))) {
+    PROTOCOL_LOGE("Failed to extract API code from sentence: %s", sentence);
+    this->stats_.parse_errors++;
     return;
   }
 
+  const uint16_t api_code = (code[2] - '0') * 100 + (code[3] - '0') * 10 + (code[4] - '0');
+
   bool valid = false;
   switch (api_code) {
     case 102:  // Wifi disconnect
     {
       // Acknowledge the message
-      this->write_sentence_("AWS_SEND:OK");
-      this->write_sentence_("AWS_IND:SEND OK");
-      this->write_sentence_("AWS_IND:DISCONNECTED");
+      this->queue_sentence_(TxPriority::Protocol, "AWS_SEND:OK");
+      this->queue_sentence_(TxPriority::Protocol, "AWS_IND:SEND OK");
+      this->queue_sentence_(TxPriority::Protocol, "AWS_IND:DISCONNECTED");
 
       // Reset handshake state
-      this->handshake_state_ = HandshakeState::Reset;
-      this->last_handshake_event_ = millis();
+      this->set_handshake_state_(HandshakeState::Reset);
       return;
     }
 
@@ -202,50 +1022,62 @@ void WinixC545Component::parse_aws_sentence_(char *sentence) {
     case 230:  // Error code
     case 240:  // Version information & filter lifetime
     {
-      // Advance sentence to first token
-      sentence += strlen("AWS_SEND=A2XX {");
-
-      // Parse each token into a KV pair
-      char *token = strtok(sentence, ",");
-      while (token != NULL) {
-        char key[4] = {0};
-        uint32_t value = 0;
-        if (sscanf(token, "\"%3s\":\"%d\"", key, &value) != 2) {
-          ESP_LOGE(TAG, "Failed to extract from token: %s", token);
+      // Locate start of payload
+      const char *payload = strchr(code, '{');
+      if (payload == nullptr) {
+        PROTOCOL_LOGE("Missing payload in sentence: %s", sentence);
+        this->stats_.parse_errors++;
+        return;
+      }
+
+      // Identical payloads carry no new state, skip parsing entirely. Replayed payloads are always decoded
+      const uint32_t hash = payload_hash(payload);
+      uint32_t &last_hash = this->payload_hashes_[(api_code - 210) / 10];
+      if (hash != last_hash || this->replaying_) {
+        if (!this->parse_payload_(payload)) {
+          this->stats_.parse_errors++;
           return;
         }
 
-        // Add state if supported
-        if (ENUM_KEY_MAP.count(std::string(key))) {
-          StateKey state_key = ENUM_KEY_MAP.at(std::string(key));
-          this->states_[state_key] = value;
+        // Keys are shared between API codes, so a repeat of another payload may change states again
+        if (!this->replaying_) {
+          for (uint32_t &other_hash : this->payload_hashes_)
+            other_hash = 0;
+          last_hash = hash;
         }
-
-        token = strtok(NULL, ",");
       }
 
+      // Record time of last full state update
+      if (api_code == 210)
+        this->stats_.last_state_time = millis();
+
       valid = true;
       break;
     }
 
     default:
-      ESP_LOGW(TAG, "Unknown API code %d: %s", api_code, sentence);
+      PROTOCOL_LOGW("Unknown API code %d: %s", api_code, sentence);
+      this->stats_.unknown_api_codes++;
       break;
   }
 
   if (valid) {
     // Acknowledge the message
-    this->write_sentence_("AWS_SEND:OK");
-    this->write_sentence_("AWS_IND:SEND OK");
+    this->queue_sentence_(TxPriority::Protocol, "AWS_SEND:OK");
+    this->queue_sentence_(TxPriority::Protocol, "AWS_IND:SEND OK");
 
     // If a valid packet was received, force connected state
-    this->handshake_state_ = HandshakeState::Connected;
-    this->last_handshake_event_ = millis();
+    this->set_handshake_state_(HandshakeState::Connected);
   }
 }
 
-void WinixC545Component::parse_sentence_(char *sentence) {
-  ESP_LOGD(TAG, "Received sentence: %s", sentence);
+void WinixC545Component::parse_sentence_(WinixStreamParser &parser) {
+  char *sentence = parser.line();
+  PROTOCOL_LOG_FULL("Received sentence: %s", sentence);
+  this->stats_.rx_sentences++;
+
+  if (this->capture_.enabled() && !this->replaying_)
+    this->capture_.push(WinixCaptureBuffer::Direction::RX, millis(), sentence, parser.length());
 
   // Example sentence formats
   // AT*ICT*MCU_READY=1.2.0
@@ -254,121 +1086,251 @@ void WinixC545Component::parse_sentence_(char *sentence) {
   // AT*ICT*AWS_SEND=A210 {"A02":"1","A03":"02","A04":"02","A05":"01","A07":"1","A21":"3706","S07":"01","S08":"97","S14":"34"}
   // AT*ICT*AWS_SEND=A220 {"S07":"01","S08":"116","S14":"34"}
 
-  // Ensure sentence starts as expected
-  if (strncmp(sentence, RX_PREFIX.c_str(), RX_PREFIX.size()) != 0) {
-    ESP_LOGW(TAG, "Received invalid sentence: %s", sentence);
-    return;
+  // Any sentence with the expected prefix shows the link is alive, unless it was replayed
+  if (parser.type() != SentenceType::Invalid && !this->replaying_) {
+    this->last_rx_time_ = millis();
+    if (!this->link_up_)
+      this->set_link_state_(true);
   }
 
-  // Advance past prefix
-  sentence += RX_PREFIX.size();
+  // Prefix and command were recognised by the stream parser
+  switch (parser.type()) {
+    case SentenceType::Invalid:
+      PROTOCOL_LOGW("Received invalid sentence: %s", sentence);
+      this->stats_.parse_errors++;
+      return;
 
-  // Parse AWS sentences from MCU
-  if (strncmp(sentence, "AWS_SEND", strlen("AWS_SEND")) == 0) {
-    this->parse_aws_sentence_(sentence);
-    return;
+    case SentenceType::AwsSend:
+      // Parse AWS sentences from MCU
+      this->parse_aws_sentence_(parser.command());
+      return;
+
+    case SentenceType::DeviceReady:
+      // Only expected after the MCU restarted, which a resumed connection need not wait out
+      if (this->handshake_state_ != HandshakeState::Resume)
+        break;
+
+      ESP_LOGI(TAG, "MCU restarted. Starting handshake.");
+      this->set_handshake_state_(HandshakeState::Reset);
+      return;
+
+    case SentenceType::McuReady:
+      ESP_LOGI(TAG, "MCU_READY");
+      this->queue_sentence_(TxPriority::Protocol, "MCU_READY:OK");
+
+      if (this->handshake_state_ == HandshakeState::ApDeviceReady) {
+        this->set_handshake_state_(HandshakeState::ApStart);
+
+        ESP_LOGI(TAG, "AP START");
+        this->queue_sentence_(TxPriority::Protocol, "AP_STARTED:OK");
+      } else {
+        this->set_handshake_state_(HandshakeState::McuReady);
+      }
+      return;
+
+    case SentenceType::MIB:
+      // Only MIB=32 is expected
+      if (strncmp(parser.arguments(), "=32", 3) != 0)
+        break;
+
+      this->set_handshake_state_(HandshakeState::MIB);
+
+      ESP_LOGI(TAG, "MIB:OK");
+      this->queue_sentence_(TxPriority::Protocol, "MIB:OK 7595");  // 7595 is version of OEM wifi module
+      return;
+
+    case SentenceType::SetMIB:
+      ESP_LOGI(TAG, "SETMIB:OK");
+      this->queue_sentence_(TxPriority::Protocol, "SETMIB:OK");
+      return;
+
+    case SentenceType::SMode:
+      this->set_handshake_state_(HandshakeState::ApReboot);
+
+      ESP_LOGI(TAG, "SMODE:OK");
+      this->queue_sentence_(TxPriority::Protocol, "SMODE:OK");
+      return;
+
+    case SentenceType::Unknown:
+      break;
   }
 
-  // Handle MCU_READY message
-  if (strncmp(sentence, "MCU_READY", strlen("MCU_READY")) == 0) {
-    ESP_LOGI(TAG, "MCU_READY");
-    this->write_sentence_("MCU_READY:OK");
+  PROTOCOL_LOGW("Unsupported sentence: %s", parser.command());
+  this->stats_.parse_errors++;
+}
 
-    if (this->handshake_state_ == HandshakeState::ApDeviceReady) {
-      this->handshake_state_ = HandshakeState::ApStart;
-      this->last_handshake_event_ = millis();
+bool WinixC545Component::read_sentence_() {
+  while (true) {
+    // Refill the chunk from the UART in bulk once consumed
+    if (this->rx_chunk_position_ == this->rx_chunk_length_) {
+      const size_t length = std::min<size_t>(this->available(), sizeof(this->rx_chunk_));
+      if (length == 0 || !this->read_array(this->rx_chunk_, length))
+        return false;
 
-      ESP_LOGI(TAG, "AP START");
-      this->write_sentence_("AP_STARTED:OK");
-    } else {
-      this->handshake_state_ = HandshakeState::McuReady;
-      this->last_handshake_event_ = millis();
+      this->rx_chunk_position_ = 0;
+      this->rx_chunk_length_ = length;
     }
 
-    return;
-  }
+    const uint32_t overflow_count = this->parser_.get_overflow_count();
+    this->rx_chunk_position_ += this->parser_.feed(this->rx_chunk_ + this->rx_chunk_position_, this->rx_chunk_length_ - this->rx_chunk_position_);
 
-  // Handle MIB=32 message
-  if (strncmp(sentence, "MIB=32", strlen("MIB=32")) == 0) {
-    this->handshake_state_ = HandshakeState::MIB;
-    this->last_handshake_event_ = millis();
+    // Check if lines were discarded due to overflow
+    if (this->parser_.get_overflow_count() != overflow_count)
+      PROTOCOL_LOGW("Discarded line exceeding %zu bytes (%u total)", this->parser_.get_capacity() - 1, this->parser_.get_overflow_count());
 
-    ESP_LOGI(TAG, "MIB:OK");
-    this->write_sentence_("MIB:OK 7595");  // 7595 is version of OEM wifi module
-    return;
+    if (this->parser_.complete())
+      return true;
   }
+}
 
-  // Handle SETMIB messages
-  if (strncmp(sentence, "SETMIB", strlen("SETMIB")) == 0) {
-    ESP_LOGI(TAG, "SETMIB:OK");
-    this->write_sentence_("SETMIB:OK");
+void WinixC545Component::set_handshake_state_(HandshakeState state) {
+  // Replayed lines must not drive the live handshake
+  if (this->replaying_)
     return;
+
+  this->handshake_state_ = state;
+  this->last_handshake_event_ = millis();
+
+  if (state == HandshakeState::Connected)
+    this->handshake_failures_ = 0;
+
+  // Persist connection status for fast resume after a reboot. Only written on change to limit flash wear
+  const bool connected = state == HandshakeState::Connected;
+  if (this->resume_handshake_ && connected != this->handshake_saved_connected_) {
+    this->handshake_saved_connected_ = connected;
+
+    const uint8_t value = connected;
+    this->handshake_pref_.save(&value);
   }
+}
+
+uint32_t WinixC545Component::handshake_backoff_(uint32_t timeout) const {
+  // Double the timeout for each consecutive failure
+  const uint8_t shift = std::min<uint8_t>(this->handshake_failures_, 16);
+  return std::min<uint64_t>(uint64_t(timeout) << shift, std::max(timeout, this->handshake_max_backoff_));
+}
 
-  // Handle SMODE messages
-  if (strncmp(sentence, "SMODE", strlen("SMODE")) == 0) {
-    this->handshake_state_ = HandshakeState::ApReboot;
-    this->last_handshake_event_ = millis();
+void WinixC545Component::handshake_failed_() {
+  ESP_LOGW(TAG, "Handshake stalled in state %d. Restarting.", this->handshake_state_);
+  this->stats_.handshake_resets++;
 
-    ESP_LOGI(TAG, "SMODE:OK");
-    this->write_sentence_("SMODE:OK");
-    return;
+  if (this->handshake_failures_ < UINT8_MAX)
+    this->handshake_failures_++;
+
+  this->set_handshake_state_(HandshakeState::Reset);
+}
+
+void WinixC545Component::set_link_state_(bool up) {
+  this->link_up_ = up;
+  this->link_recoveries_ = 0;
+
+  if (up) {
+    ESP_LOGI(TAG, "Link to MCU established");
+    this->status_clear_warning();
+  } else {
+    ESP_LOGW(TAG, "No sentence received from MCU for %u ms, link lost", this->link_timeout_);
+    this->status_set_warning();
+    this->invalidate_states_();
   }
 
-  ESP_LOGW(TAG, "Unsupported sentence: %s", sentence);
+#ifdef USE_BINARY_SENSOR
+  if (this->link_binary_sensor_ != nullptr)
+    this->link_binary_sensor_->publish_state(up);
+#endif
 }
 
-bool WinixC545Component::readline_(char data, char *buffer, int max_length) {
-  static int position = 0;
+void WinixC545Component::invalidate_states_() {
+  // Forget reported states so every value is published again once the link recovers
+  this->device_states_.clear();
+  memset(this->payload_hashes_, 0, sizeof(this->payload_hashes_));
+  this->aqi_indicator_raw_value_ = 0;
 
-  // Read failed
-  if (data < 0) return false;
+#ifdef USE_SENSOR
+  // Mark sensors unavailable
+  for (sensor::Sensor *sensor : {this->filter_age_sensor_, this->filter_lifetime_sensor_, this->filter_remaining_sensor_, this->filter_eta_sensor_, this->aqi_sensor_, this->light_sensor_}) {
+    if (sensor != nullptr)
+      sensor->publish_state(NAN);
+  }
 
-  switch (data) {
-    case '\n':  // Ignore new-lines
-      break;
+  for (size_t i = 0; i < this->custom_key_count_; i++) {
+    if (this->custom_keys_[i].sensor != nullptr)
+      this->custom_keys_[i].sensor->publish_state(NAN);
+  }
 
-    case '\r': {             // Return on CR
-      buffer[position] = 0;  // Ensure buffer is null terminated
-      position = 0;          // Reset position for next line
-      return true;
-    }
+  this->aqi_policy_.reset();
+  this->light_policy_.reset();
+  this->filter_remaining_published_ = -1;
+  this->filter_eta_published_ = -1;
+#endif
+}
 
-    default:
-      if (position < max_length - 1)
-        buffer[position++] = data;
+void WinixC545Component::publish_telemetry_() {
+  uint8_t frame[TELEMETRY_FRAME_SIZE];
+  const uint8_t flags = this->handshake_state_ == HandshakeState::Connected ? TELEMETRY_FLAG_CONNECTED : 0;
+  const size_t length = encode_telemetry_frame(frame, this->device_states_, this->telemetry_sequence_++, millis(), flags);
+  this->telemetry_callback_.call(frame, length);
+}
 
-      break;
+void WinixC545Component::check_link_() {
+  const uint32_t now = millis();
+  if ((now - this->last_rx_time_) < this->link_timeout_)
+    return;
+
+  if (this->link_up_) {
+    this->set_link_state_(false);
+  } else if ((now - this->link_recovery_time_) < this->link_timeout_) {
+    // Give the last recovery attempt time to work
+    return;
   }
 
-  // No end of line has been found
-  return false;
+  // Re-handshake first, the MCU may have reset. If that didn't help, reinitialize the UART as well
+  this->link_recovery_time_ = now;
+  if (this->link_recoveries_ < UINT8_MAX)
+    this->link_recoveries_++;
+
+  if (this->link_recoveries_ > 1) {
+    ESP_LOGW(TAG, "Reinitializing UART");
+    this->parent_->load_settings(false);
+    this->rx_chunk_position_ = this->rx_chunk_length_ = 0;
+  }
+
+  ESP_LOGW(TAG, "Restarting handshake to recover link (attempt %u)", this->link_recoveries_);
+  this->handshake_failures_ = 0;
+  this->set_handshake_state_(HandshakeState::Reset);
 }
 
 void WinixC545Component::update_handshake_state_() {
+  const uint32_t elapsed = millis() - this->last_handshake_event_;
+
   switch (this->handshake_state_) {
     case HandshakeState::Connected:
       // Protocol is connected, all good
       return;
 
-    case HandshakeState::Reset:
-    case HandshakeState::DeviceReady: {
-      // If there was activity recently assume the handshake is in progress
-      if ((millis() - this->last_handshake_event_) < 10000)
+    case HandshakeState::Reset: {
+      // Start immediately unless recent attempts have failed
+      if (this->handshake_failures_ != 0 && elapsed < this->handshake_backoff_(this->handshake_timeout_))
         return;
 
       // Indicate device is ready to start handshake with MCU
-      this->handshake_state_ = HandshakeState::DeviceReady;
-      this->last_handshake_event_ = millis();
+      this->set_handshake_state_(HandshakeState::DeviceReady);
 
       ESP_LOGI(TAG, "DEVICEREADY");
-      this->write_sentence_("DEVICEREADY");
+      this->queue_sentence_(TxPriority::Protocol, "DEVICEREADY");
+      break;
+    }
+
+    case HandshakeState::DeviceReady: {
+      // Wait for the MCU to respond
+      if (elapsed < this->handshake_backoff_(this->device_ready_timeout_))
+        return;
+
+      this->handshake_failed_();
       break;
     }
 
     case HandshakeState::MIB: {
-      this->handshake_state_ = HandshakeState::Connected;
-      this->last_handshake_event_ = millis();
+      this->set_handshake_state_(HandshakeState::Connected);
 
       // Some subset of these may be needed
       // *ICT*ASSOCIATED:0
@@ -377,74 +1339,209 @@ void WinixC545Component::update_handshake_state_() {
       // *ICT*AWS_IND:SUBSCRIBE OK
       // *ICT*AWS_IND:CONNECT OK
       ESP_LOGI(TAG, "CONNECTED");
-      this->write_sentence_("AWS_IND:CONNECT OK");
+      this->queue_sentence_(TxPriority::Protocol, "AWS_IND:CONNECT OK");
       break;
     }
 
     case HandshakeState::ApReboot: {
       // AP mode requested, pretend to reboot into AP
-      this->handshake_state_ = HandshakeState::ApDeviceReady;
-      this->last_handshake_event_ = millis();
+      this->set_handshake_state_(HandshakeState::ApDeviceReady);
 
       ESP_LOGI(TAG, "AP DEVICEREADY");
-      this->write_sentence_("DEVICEREADY");
+      this->queue_sentence_(TxPriority::Protocol, "DEVICEREADY");
       break;
     }
 
     case HandshakeState::ApStart: {
       // Exit AP mode
-      this->handshake_state_ = HandshakeState::ApStop;
-      this->last_handshake_event_ = millis();
+      this->set_handshake_state_(HandshakeState::ApStop);
 
       ESP_LOGI(TAG, "AP STOP");
-      this->write_sentence_("AP_STOPED:OK");
-      this->write_sentence_("ASSOCIATED:0");
+      this->queue_sentence_(TxPriority::Protocol, "AP_STOPED:OK");
+      this->queue_sentence_(TxPriority::Protocol, "ASSOCIATED:0");
       // TODO could get real network info but I don't think it matters
-      this->write_sentence_("IPALLOCATED:10.100.1.250 255.255.255.0 10.100.1.1 10.100.1.6");
-      this->write_sentence_("AWS_IND:CONNECT OK");
+      this->queue_sentence_(TxPriority::Protocol, "IPALLOCATED:10.100.1.250 255.255.255.0 10.100.1.1 10.100.1.6");
+      this->queue_sentence_(TxPriority::Protocol, "AWS_IND:CONNECT OK");
+      break;
+    }
+
+    case HandshakeState::Resume: {
+      // Resumed connection after reboot, wait for the MCU to send a valid packet
+      if (elapsed < this->handshake_timeout_)
+        return;
+
+      // Nothing received, MCU likely rebooted too. Start a full handshake
+      ESP_LOGI(TAG, "Resume failed. Starting handshake.");
+      this->set_handshake_state_(HandshakeState::Reset);
       break;
     }
 
     default: {
       // If in an intermediate state and no activity occurs for a while reset the state machine
-      if ((millis() - this->last_handshake_event_) < 10000)
+      if (elapsed < this->handshake_backoff_(this->handshake_timeout_))
         return;
 
-      // Reset handshake state
-      ESP_LOGW(TAG, "Handshake stalled in state %d. Restarting.", this->handshake_state_);
-      this->handshake_state_ = HandshakeState::Reset;
+      this->handshake_failed_();
       break;
     }
   }
 }
 
 void WinixC545Component::loop() {
-  static char buffer[MAX_LINE_LENGTH];
+  // Fast path when idle. Timed work happens in scheduler callbacks so an idle purifier costs almost nothing
+  if (this->handshake_state_ == HandshakeState::Connected && this->available() == 0 && this->rx_chunk_position_ == this->rx_chunk_length_ && this->pending_commands_.empty() &&
+      this->tx_queue_.empty() && this->inflight_commands_.empty() && !this->restore_pending_ && !this->replay_pending_ && !this->saved_states_dirty_)
+    return;
+
+  const uint32_t loop_start = micros();
 
   // Handle protocol handshake state
   this->update_handshake_state_();
 
-  // Publish states as needed
+  // Retry or revert commands which have not been acknowledged
+  this->check_inflight_timeouts_();
+
+  // Send pending commands once the coalescing window has elapsed
+  if (!this->pending_commands_.empty() && (millis() - this->pending_commands_time_) >= this->command_coalesce_window_)
+    this->flush_commands_();
+
+  // Drain all complete sentences, within the per-loop budget
+  const uint32_t start = millis();
+  uint8_t sentences = 0;
+  while (this->read_sentence_()) {
+    // Sentence received, dispatch it and send any replies
+    this->parse_sentence_(this->parser_);
+    this->drain_tx_queue_();
+
+    // Leave remaining data for the next loop if budget is exhausted
+    if (++sentences >= this->max_sentences_per_loop_ || (millis() - start) >= this->max_loop_time_)
+      break;
+  }
+
+  // Match received states against outstanding commands
+  this->update_inflight_commands_();
+
+  // Publish restored states as provisional until the MCU reports
+  if (this->restore_pending_)
+    this->restore_states_();
+
+  // Reapply restored commands once the MCU has reported its full state, so only differing keys are sent
+  if (this->replay_pending_ && this->handshake_state_ == HandshakeState::Connected && this->stats_.last_state_time != 0)
+    this->replay_states_();
+
+  // Save states for restore after reboot
+  if (this->restore_state_)
+    this->save_states_();
+
+  // React to AQI and speed changes immediately, dwell and override timeouts are checked by a timer
+  if (this->states_.has(StateKey::AQI) || this->states_.has(StateKey::Speed))
+    this->update_aqi_control_();
+
+  // Send queued sentences, paced sentences remain for a later loop
+  this->drain_tx_queue_();
+
+  // Publish states from all parsed sentences at once
   this->publish_state_();
 
-  // Return if no data available
-  if (!this->available())
+  // Record loop processing time
+  const uint32_t loop_time = micros() - loop_start;
+  this->stats_.loop_time_max = std::max(this->stats_.loop_time_max, loop_time);
+  this->stats_.loop_time_total += loop_time;
+  this->stats_.loop_count++;
+}
+
+void WinixC545Component::request_refresh() {
+  // Handshake will provide state once connected
+  if (this->handshake_state_ != HandshakeState::Connected) {
+    ESP_LOGD(TAG, "Not connected, skipping refresh");
     return;
+  }
 
-  // Read all available data until the first sentence is received
-  while (this->available() > 0) {
-    bool found = this->readline_(this->read(), buffer, MAX_LINE_LENGTH);
-    if (!found)
-      continue;
+  // One queued request is enough
+  if (this->tx_queue_.contains(TxPriority::Refresh))
+    return;
+
+  // The MCU sends a full state update in response to a connection indication
+  ESP_LOGD(TAG, "Requesting state refresh");
+  this->queue_sentence_(TxPriority::Refresh, "AWS_IND:CONNECT OK");
+}
+
+void WinixC545Component::dump_capture() {
+  if (!this->capture_.enabled()) {
+    ESP_LOGW(TAG, "Capture is not enabled");
+    return;
+  }
+
+  ESP_LOGI(TAG, "Capture contains %zu lines:", this->capture_.size());
+  this->capture_.for_each([](const WinixCaptureBuffer::Header &header, const char *line) {
+    ESP_LOGI(TAG, "  [%10u] %s %s", header.timestamp, header.direction == WinixCaptureBuffer::Direction::RX ? "RX" : "TX", line);
+  });
+}
 
-    // Line received, parse it
-    this->parse_sentence_(buffer);
+void WinixC545Component::replay_capture() {
+  if (!this->capture_.enabled()) {
+    ESP_LOGW(TAG, "Capture is not enabled");
     return;
   }
+
+  ESP_LOGI(TAG, "Replaying %zu captured lines", this->capture_.size());
+
+  // Replayed lines are decoded and logged only. Replies are not sent, lines are not captured again
+  // and the handshake, link and reported states are left unchanged
+  const ProtocolStats stats = this->stats_;
+  this->replaying_ = true;
+  this->capture_.for_each([this](const WinixCaptureBuffer::Header &header, const char *line) {
+    if (header.direction != WinixCaptureBuffer::Direction::RX)
+      return;
+
+    // Parse with separate storage, a partial line may be in the live parser
+    char storage[UINT8_MAX + 1];
+    WinixStreamParser parser;
+    parser.set_storage(storage, sizeof(storage));
+    parser.feed(reinterpret_cast<const uint8_t *>(line), header.length);
+    parser.feed(reinterpret_cast<const uint8_t *>("\r"), 1);
+    if (parser.complete())
+      this->parse_sentence_(parser);
+  });
+  this->replaying_ = false;
+  this->stats_ = stats;
+}
+
+void WinixC545Component::update() {
+  // Avoid extra traffic if a full state update was received recently
+  if (this->stats_.last_state_time != 0 && (millis() - this->stats_.last_state_time) < this->get_update_interval())
+    return;
+
+  this->request_refresh();
 }
 
 void WinixC545Component::dump_config() {
   ESP_LOGCONFIG(TAG, "Winix C545:");
+  LOG_UPDATE_INTERVAL(this);
+  ESP_LOGCONFIG(TAG, "  Max Sentences Per Loop: %u", this->max_sentences_per_loop_);
+  ESP_LOGCONFIG(TAG, "  Max Loop Time: %u ms", this->max_loop_time_);
+  ESP_LOGCONFIG(TAG, "  Command Coalesce Window: %u ms", this->command_coalesce_window_);
+  ESP_LOGCONFIG(TAG, "  Command Timeout: %u ms", this->command_timeout_);
+  ESP_LOGCONFIG(TAG, "  Command Retries: %u", this->command_retries_);
+  ESP_LOGCONFIG(TAG, "  TX Interval: %u ms", this->tx_interval_);
+  ESP_LOGCONFIG(TAG, "  Device Ready Timeout: %u ms", this->device_ready_timeout_);
+  ESP_LOGCONFIG(TAG, "  Handshake Timeout: %u ms", this->handshake_timeout_);
+  ESP_LOGCONFIG(TAG, "  Handshake Max Backoff: %u ms", this->handshake_max_backoff_);
+  ESP_LOGCONFIG(TAG, "  Resume Handshake: %s", YESNO(this->resume_handshake_));
+  ESP_LOGCONFIG(TAG, "  Max Line Length: %zu bytes", this->parser_.get_capacity());
+  ESP_LOGCONFIG(TAG, "  Link Timeout: %u ms", this->link_timeout_);
+  ESP_LOGCONFIG(TAG, "  Telemetry Interval: %u ms", this->telemetry_interval_);
+  ESP_LOGCONFIG(TAG, "  AQI Control: %s", YESNO(this->aqi_controller_.enabled()));
+  if (this->aqi_controller_.enabled()) {
+    ESP_LOGCONFIG(TAG, "    Min Dwell: %u ms", this->aqi_control_min_dwell_);
+    ESP_LOGCONFIG(TAG, "    Override Timeout: %u ms", this->aqi_control_override_timeout_);
+  }
+  ESP_LOGCONFIG(TAG, "  Capture Buffer Size: %zu bytes", this->capture_buffer_size_);
+  ESP_LOGCONFIG(TAG, "  Restore State: %s", YESNO(this->restore_state_));
+  if (this->restore_state_) {
+    ESP_LOGCONFIG(TAG, "  Apply Restored State: %s", YESNO(this->apply_restored_state_));
+    ESP_LOGCONFIG(TAG, "  Restore Save Delay: %u ms", this->restore_save_delay_);
+  }
 
 #ifdef USE_FAN
   if (this->fan_) this->fan_->dump_config();
@@ -453,30 +1550,129 @@ void WinixC545Component::dump_config() {
 #ifdef USE_SENSOR
   LOG_SENSOR("  ", "Filter Age Sensor", this->filter_age_sensor_);
   LOG_SENSOR("  ", "Filter Lifetime Sensor", this->filter_lifetime_sensor_);
+  LOG_SENSOR("  ", "Filter Remaining Sensor", this->filter_remaining_sensor_);
+  LOG_SENSOR("  ", "Filter ETA Sensor", this->filter_eta_sensor_);
   LOG_SENSOR("  ", "AQI Sensor", this->aqi_sensor_);
   LOG_SENSOR("  ", "Light Sensor", this->light_sensor_);
+  LOG_SENSOR("  ", "Command Ack Latency Sensor", this->command_ack_latency_sensor_);
+  LOG_SENSOR("  ", "Command Retry Count Sensor", this->command_retry_count_sensor_);
+  LOG_SENSOR("  ", "Command Failure Count Sensor", this->command_failure_count_sensor_);
+  LOG_SENSOR("  ", "RX Sentences Sensor", this->rx_sentences_sensor_);
+  LOG_SENSOR("  ", "TX Sentences Sensor", this->tx_sentences_sensor_);
+  LOG_SENSOR("  ", "Parse Errors Sensor", this->parse_errors_sensor_);
+  LOG_SENSOR("  ", "Unknown API Codes Sensor", this->unknown_api_codes_sensor_);
+  LOG_SENSOR("  ", "Line Overflows Sensor", this->line_overflows_sensor_);
+  LOG_SENSOR("  ", "Handshake Resets Sensor", this->handshake_resets_sensor_);
+  LOG_SENSOR("  ", "Time Since State Sensor", this->time_since_state_sensor_);
+  LOG_SENSOR("  ", "Loop Time Max Sensor", this->loop_time_max_sensor_);
+  LOG_SENSOR("  ", "Loop Time Avg Sensor", this->loop_time_avg_sensor_);
+  this->aqi_statistics_.dump_config("AQI");
+  this->light_statistics_.dump_config("Light");
 #endif
 
 #ifdef USE_TEXT_SENSOR
   LOG_TEXT_SENSOR("  ", "AQI Indicator Text Sensor", this->aqi_indicator_text_sensor_);
 #endif
 
+#ifdef USE_BINARY_SENSOR
+  LOG_BINARY_SENSOR("  ", "Link Binary Sensor", this->link_binary_sensor_);
+#endif
+
 #ifdef USE_SWITCH
   LOG_SWITCH("  ", "Plasmawave Switch", this->plasmawave_switch_);
 #endif
+
+  for (size_t i = 0; i < this->key_entity_count_; i++)
+    ESP_LOGCONFIG(TAG, "  Key Entity: %s", this->key_name_(this->key_entities_[i]->get_key()));
+
+  for (size_t i = 0; i < this->custom_key_count_; i++) {
+    [[maybe_unused]] const CustomKey &custom = this->custom_keys_[i];
+    ESP_LOGCONFIG(TAG, "  Custom Key %s:", custom.name);
+#ifdef USE_SENSOR
+    if (custom.sensor != nullptr) {
+      LOG_SENSOR("    ", "Sensor", custom.sensor);
+      ESP_LOGCONFIG(TAG, "      Multiply: %.3f", custom.multiply);
+    }
+#endif
+#ifdef USE_SWITCH
+    LOG_SWITCH("    ", "Switch", custom.sw);
+#endif
+  }
 }
 
 void WinixC545Component::setup() {
-  // Restore state
-  // auto restore = this->restore_state_();
-  // if (restore.has_value()) {
-  //   restore->apply(*this);
-  //   this->write_state_();
-  // }
-
-  // Reset handshake
-  this->handshake_state_ = HandshakeState::Reset;
+  // Restore states saved before reboot
+  if (this->restore_state_) {
+    // Offset hash to keep separate from handshake preference
+    this->saved_states_pref_ = global_preferences->make_preference<SavedStates>(this->preference_hash_ + 1);
+    if (this->saved_states_pref_.load(&this->saved_states_)) {
+      ESP_LOGI(TAG, "Restored %zu states", this->saved_states_.observed.size());
+      this->restore_pending_ = true;
+      this->replay_pending_ = this->apply_restored_state_;
+    } else {
+      this->saved_states_ = {};
+    }
+  }
+
+  // Check if the protocol was connected before reboot
+  uint8_t connected = 0;
+  if (this->resume_handshake_) {
+    this->handshake_pref_ = global_preferences->make_preference<uint8_t>(this->preference_hash_);
+    if (this->handshake_pref_.load(&connected))
+      this->handshake_saved_connected_ = connected != 0;
+  }
+
+  if (this->handshake_saved_connected_) {
+    // Assume MCU is still connected and wait for it to send state
+    ESP_LOGI(TAG, "Resuming connected handshake");
+    this->handshake_state_ = HandshakeState::Resume;
+  } else {
+    // Reset handshake, DEVICEREADY is sent on first loop
+    this->handshake_state_ = HandshakeState::Reset;
+  }
   this->last_handshake_event_ = millis();
+  this->handshake_failures_ = 0;
+
+  // Allocate storage for lines longer than the default
+  if (this->max_line_length_ > WinixStreamParser::DEFAULT_MAX_LINE_LENGTH)
+    this->parser_.set_storage(new char[this->max_line_length_], this->max_line_length_);
+
+  // Allocate capture storage once, nothing is allocated while capturing
+  if (this->capture_buffer_size_ != 0)
+    this->capture_.set_storage(new uint8_t[this->capture_buffer_size_], this->capture_buffer_size_);
+
+  // Periodically publish a snapshot of all states as one frame
+  if (this->telemetry_interval_ != 0)
+    this->set_interval("telemetry", this->telemetry_interval_, [this]() { this->publish_telemetry_(); });
+
+  // Watch for the MCU going silent
+  if (this->link_timeout_ != 0) {
+    this->last_rx_time_ = millis();
+    this->set_interval("link_watchdog", LINK_CHECK_INTERVAL, [this]() { this->check_link_(); });
+  }
+
+#ifdef USE_BINARY_SENSOR
+  if (this->link_binary_sensor_ != nullptr)
+    this->link_binary_sensor_->publish_state(false);
+#endif
+
+  // Check AQI control once dwell and override times elapse
+  if (this->aqi_controller_.enabled())
+    this->set_interval("aqi_control", AQI_CONTROL_INTERVAL, [this]() { this->update_aqi_control_(); });
+
+#ifdef USE_SENSOR
+  // Check for deferred and heartbeat publishes
+  if (this->aqi_policy_.is_timed() || this->light_policy_.is_timed())
+    this->set_interval("publish_policy", POLICY_CHECK_INTERVAL, [this]() { this->publish_policy_sensors_(); });
+
+  // Rolling statistics of reported values
+  this->setup_statistics_(this->aqi_statistics_, "aqi_statistics", StateKey::AQI);
+  this->setup_statistics_(this->light_statistics_, "light_statistics", StateKey::Light);
+
+  // Periodically publish protocol diagnostics
+  if (this->diagnostics_interval_ != 0)
+    this->set_interval("diagnostics", this->diagnostics_interval_, [this]() { this->publish_diagnostics_(); });
+#endif
 }
 
 void WinixC545Fan::dump_config() {
@@ -485,15 +1681,69 @@ void WinixC545Fan::dump_config() {
 #endif
 }
 
+const WinixC545Fan::SpeedMapping WinixC545Fan::SPEED_MAP[] = {
+    {1, 1, Preset::None},             // Low
+    {2, 2, Preset::None},             // Medium
+    {3, 3, Preset::None},             // High
+    {SPEED_TURBO, 4, Preset::None},   // Turbo
+    {SPEED_SLEEP, 0, Preset::Sleep},  // Sleep TODO speed?
+};
+
+const char *WinixC545Fan::preset_to_string_(Preset preset) {
+  switch (preset) {
+    case Preset::Sleep:
+      return PRESET_SLEEP;
+    case Preset::Auto:
+      return PRESET_AUTO;
+    default:
+      return PRESET_NONE;
+  }
+}
+
+WinixC545Fan::Preset WinixC545Fan::preset_from_string_(const std::string &preset) {
+  if (preset == PRESET_SLEEP)
+    return Preset::Sleep;
+
+  if (preset == PRESET_AUTO)
+    return Preset::Auto;
+
+  return Preset::None;
+}
+
+const WinixC545Fan::SpeedMapping *WinixC545Fan::speed_from_value_(uint16_t value) {
+  for (const auto &mapping : SPEED_MAP) {
+    if (mapping.value == value)
+      return &mapping;
+  }
+
+  return nullptr;
+}
+
+uint8_t WinixC545Fan::value_from_speed_(int speed) {
+  for (const auto &mapping : SPEED_MAP) {
+    if (mapping.preset == Preset::None && mapping.speed == speed)
+      return mapping.value;
+  }
+
+  return speed;
+}
+
+void WinixC545Fan::set_preset_(Preset preset) {
+  this->preset_ = preset;
+
+  // Convert to the fan API string only on change
+  this->preset_mode = preset_to_string_(preset);
+}
+
 void WinixC545Fan::update_state(const WinixStateMap &states) {
   // Nothing to do if empty
   if (states.empty())
     return;
 
   bool publish = false;
-  for (const auto &state : states) {
-    const StateKey key = state.first;
-    const uint16_t value = state.second;
+  for (const auto state : states) {
+    const StateKey key = state.key;
+    const uint16_t value = state.value;
 
     // Handle fan states
     switch (key) {
@@ -513,13 +1763,8 @@ void WinixC545Fan::update_state(const WinixStateMap &states) {
 
       case StateKey::Speed: {
         // Speed
-        uint8_t speed = 0;
-        if (value == 5)  // Turbo
-          speed = 4;
-        else if (value == 6)  // Sleep
-          speed = 0;          // TODO?
-        else
-          speed = value;
+        const SpeedMapping *mapping = speed_from_value_(value);
+        const uint8_t speed = mapping != nullptr ? mapping->speed : value;
 
         if (speed == this->speed)
           continue;
@@ -528,8 +1773,9 @@ void WinixC545Fan::update_state(const WinixStateMap &states) {
         this->speed = speed;
 
         // Set preset mode to Sleep if speed indicates sleep and Auto is not enabled
-        if (this->preset_mode != PRESET_AUTO)
-          this->preset_mode = (value == 6) ? PRESET_SLEEP : PRESET_NONE;
+        const Preset preset = mapping != nullptr ? mapping->preset : Preset::None;
+        if (this->preset_ != Preset::Auto && this->preset_ != preset)
+          this->set_preset_(preset);
 
         publish = true;
 
@@ -538,17 +1784,17 @@ void WinixC545Fan::update_state(const WinixStateMap &states) {
 
       case StateKey::Auto: {
         // Auto
-        std::string preset_mode = this->preset_mode;
+        Preset preset = this->preset_;
         if (value == 1)
-          preset_mode = PRESET_AUTO;
-        else if (this->preset_mode == PRESET_AUTO)
-          preset_mode = PRESET_NONE;
+          preset = Preset::Auto;
+        else if (this->preset_ == Preset::Auto)
+          preset = Preset::None;
 
-        if (preset_mode == this->preset_mode)
+        if (preset == this->preset_)
           continue;
 
         // Preset has changed, publish
-        this->preset_mode = preset_mode;
+        this->set_preset_(preset);
         publish = true;
 
         break;
@@ -572,19 +1818,20 @@ void WinixC545Fan::control(const fan::FanCall &call) {
   if (call.get_speed().has_value() && this->speed != *call.get_speed()) {
     // Speed has changed
     this->speed = *call.get_speed();
-    states.emplace(StateKey::Speed, this->speed == 4 ? 5 : this->speed);
+    states.emplace(StateKey::Speed, value_from_speed_(this->speed));
   }
 
-  if (this->preset_mode != call.get_preset_mode()) {
-    this->preset_mode = call.get_preset_mode();
+  const Preset preset = preset_from_string_(call.get_preset_mode());
+  if (this->preset_ != preset) {
+    this->set_preset_(preset);
 
     // Update auto mode
-    if (this->preset_mode == PRESET_AUTO)
+    if (preset == Preset::Auto)
       states.emplace(StateKey::Auto, 1);
 
     // Set sleep mode
-    if (this->preset_mode == PRESET_SLEEP)
-      states.emplace(StateKey::Speed, 6);
+    if (preset == Preset::Sleep)
+      states.emplace(StateKey::Speed, SPEED_SLEEP);
   }
 
   this->parent_->write_state(states);
@@ -603,5 +1850,55 @@ void WinixC545Switch::write_state(bool state) {
   this->publish_state(state);
 }
 
+void WinixKeyEntity::write_value_(uint16_t value) {
+  WinixStateMap states;
+  states.set(this->key_, value);
+  this->parent_->write_state(states);
+}
+
+#ifdef USE_SELECT
+void WinixC545Select::update_value(uint16_t value) {
+  const auto &options = this->traits.get_options();
+  for (size_t i = 0; i < this->value_count_ && i < options.size(); i++) {
+    if (this->values_[i] != value)
+      continue;
+
+    if (this->state != options[i])
+      this->publish_state(options[i]);
+    this->unmatched_value_ = -1;
+    return;
+  }
+
+  // Warn once for each value without an option, not on every report
+  if (this->unmatched_value_ != value)
+    ESP_LOGW(TAG, "No option for value %u", value);
+  this->unmatched_value_ = value;
+}
+
+void WinixC545Select::control(const std::string &value) {
+  const auto &options = this->traits.get_options();
+  for (size_t i = 0; i < this->value_count_ && i < options.size(); i++) {
+    if (options[i] != value)
+      continue;
+
+    this->write_value_(this->values_[i]);
+    this->publish_state(value);
+    return;
+  }
+}
+#endif
+
+#ifdef USE_NUMBER
+void WinixC545Number::update_value(uint16_t value) {
+  if (value != this->state)
+    this->publish_state(value);
+}
+
+void WinixC545Number::control(float value) {
+  this->write_value_(static_cast<uint16_t>(std::lround(value)));
+  this->publish_state(value);
+}
+#endif
+
 }  // namespace winix_c545
-}  // namespace esphome
\ No newline at end of file
+}  // namespace esphome
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
 
 #include "esphome/components/uart/uart.h"
 #include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
+#include "protocol.h"
 #ifdef USE_FAN
 #include "esphome/components/fan/fan.h"
 #endif
@@ -17,55 +19,152 @@
 #ifdef USE_SWITCH
 #include "esphome/components/switch/switch.h"
 #endif
+#ifdef USE_BINARY_SENSOR
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#endif
+#ifdef USE_SELECT
+#include "esphome/components/select/select.h"
+#endif
+#ifdef USE_NUMBER
+#include "esphome/components/number/number.h"
+#endif
+
+// Protocol logging levels, selected with the log_protocol option
+#define WINIX_C545_LOG_PROTOCOL_NONE 0
+#define WINIX_C545_LOG_PROTOCOL_ERRORS 1
+#define WINIX_C545_LOG_PROTOCOL_SUMMARY 2
+#define WINIX_C545_LOG_PROTOCOL_FULL 3
+
+#ifndef WINIX_C545_LOG_PROTOCOL
+#define WINIX_C545_LOG_PROTOCOL WINIX_C545_LOG_PROTOCOL_FULL
+#endif
 
 namespace esphome {
 namespace winix_c545 {
 
-// Control keys
-static constexpr const char *KEY_POWER = "A02";
-static constexpr const char *KEY_AUTO = "A03";
-static constexpr const char *KEY_SPEED = "A04";
-static constexpr const char *KEY_PLASMAWAVE = "A07";
-
-// Sensor keys
-static constexpr const char *KEY_FILTER_AGE = "A21";
-static constexpr const char *KEY_FILTER_LIFETIME = "P01";
-static constexpr const char *KEY_AQI_INDICATOR = "S07";
-static constexpr const char *KEY_AQI = "S08";
-static constexpr const char *KEY_LIGHT = "S14";
-
-enum class StateKey {
-  // Control keys
-  Power,
-  Auto,
-  Speed,
-  Plasmawave,
-
-  // Sensor keys
-  FilterAge,
-  FilterLifetime,
-  AQIIndicator,
-  AQI,
-  Light
+#ifdef USE_SENSOR
+// Limits how often a sensor publishes changes
+class WinixPublishPolicy {
+ public:
+  void configure(uint32_t min_interval, uint32_t heartbeat, float delta, float delta_relative) {
+    this->min_interval_ = min_interval;
+    this->heartbeat_ = heartbeat;
+    this->delta_ = delta;
+    this->delta_relative_ = delta_relative;
+  }
+
+  // Record the latest raw value
+  void set_value(float value) {
+    this->value_ = value;
+    this->has_value_ = true;
+  }
+  float get_value() const { return this->value_; }
+
+  // True if publishes may be deferred or repeated and need periodic checks
+  bool is_timed() const { return this->min_interval_ != 0 || this->heartbeat_ != 0; }
+
+  // Returns true if the latest value should be published now, and marks it as published
+  bool should_publish(uint32_t now);
+
+  // Forget the latest and published values, the next value is published immediately
+  void reset() {
+    this->has_value_ = false;
+    this->has_published_ = false;
+  }
+
+ protected:
+  // Minimum time between published changes
+  uint32_t min_interval_{0};
+  // Maximum time between publishes, even if unchanged. 0 to disable
+  uint32_t heartbeat_{0};
+  // Minimum absolute and relative change from the last published value
+  float delta_{0};
+  float delta_relative_{0};
+
+  float value_{0};
+  bool has_value_{false};
+  float published_value_{0};
+  bool has_published_{false};
+  uint32_t last_publish_time_{0};
 };
 
-// Define an alias for map of device states
-using WinixStateMap = std::unordered_map<StateKey, uint16_t>;
+// Derived sensors computed from periodic samples of a reported value
+class WinixSensorStatistics {
+ public:
+  void configure(uint32_t sample_interval, size_t window_size, float ema_alpha) {
+    this->sample_interval_ = sample_interval;
+    this->window_size_ = window_size;
+    this->stats_.set_ema_alpha(ema_alpha);
+  }
+
+  void set_sensors(sensor::Sensor *mean, sensor::Sensor *min, sensor::Sensor *max, sensor::Sensor *ema, sensor::Sensor *rate) {
+    this->mean_sensor_ = mean;
+    this->min_sensor_ = min;
+    this->max_sensor_ = max;
+    this->ema_sensor_ = ema;
+    this->rate_sensor_ = rate;
+  }
+
+  bool enabled() const { return this->sample_interval_ != 0; }
+  uint32_t get_sample_interval() const { return this->sample_interval_; }
+
+  // Allocate the sample window, called once at setup
+  void setup() { this->stats_.allocate(this->window_size_); }
+
+  // Add a sample and publish the derived sensors
+  void sample(uint16_t value);
+
+  void dump_config(const char *name) const;
+
+ protected:
+  uint32_t sample_interval_{0};
+  size_t window_size_{0};
+  WinixRollingStats stats_;
+
+  sensor::Sensor *mean_sensor_{nullptr};
+  sensor::Sensor *min_sensor_{nullptr};
+  sensor::Sensor *max_sensor_{nullptr};
+  sensor::Sensor *ema_sensor_{nullptr};
+  sensor::Sensor *rate_sensor_{nullptr};  // Change per minute over the window
+};
+#endif
 
 class WinixC545Fan;
+class WinixC545CustomSwitch;
+class WinixKeyEntity;
 
-class WinixC545Component : public uart::UARTDevice, public Component {
+class WinixC545Component : public uart::UARTDevice, public PollingComponent {
 #ifdef USE_SENSOR
   SUB_SENSOR(filter_age)
   SUB_SENSOR(filter_lifetime)
+  SUB_SENSOR(filter_remaining)
+  SUB_SENSOR(filter_eta)
   SUB_SENSOR(aqi)
   SUB_SENSOR(light)
+  SUB_SENSOR(command_ack_latency)
+  SUB_SENSOR(command_retry_count)
+  SUB_SENSOR(command_failure_count)
+
+  // Diagnostics
+  SUB_SENSOR(rx_sentences)
+  SUB_SENSOR(tx_sentences)
+  SUB_SENSOR(parse_errors)
+  SUB_SENSOR(unknown_api_codes)
+  SUB_SENSOR(line_overflows)
+  SUB_SENSOR(handshake_resets)
+  SUB_SENSOR(time_since_state)
+  SUB_SENSOR(loop_time_max)
+  SUB_SENSOR(loop_time_avg)
 #endif
 
 #ifdef USE_TEXT_SENSOR
   SUB_TEXT_SENSOR(aqi_indicator)
 #endif
 
+#ifdef USE_BINARY_SENSOR
+  SUB_BINARY_SENSOR(link)
+#endif
+
 #ifdef USE_SWITCH
   SUB_SWITCH(plasmawave)
 #endif
@@ -73,22 +172,100 @@ class WinixC545Component : public uart::UARTDevice, public Component {
  public:
   void setup() override;
   void loop() override;
+  void update() override;
   void dump_config() override;
 
   void write_state(const WinixStateMap &);
 
+  // Request the MCU to send a full state update
+  void request_refresh();
+
+  // Log the contents of the capture buffer
+  void dump_capture();
+  // Decode and log captured RX lines again, without sending replies or changing live state
+  void replay_capture();
+
+  void set_max_sentences_per_loop(uint8_t max_sentences) { this->max_sentences_per_loop_ = max_sentences; }
+  void set_max_loop_time(uint32_t max_loop_time) { this->max_loop_time_ = max_loop_time; }
+  void set_command_coalesce_window(uint32_t window) { this->command_coalesce_window_ = window; }
+  void set_command_timeout(uint32_t timeout) { this->command_timeout_ = timeout; }
+  void set_command_retries(uint8_t retries) { this->command_retries_ = retries; }
+  void set_tx_interval(uint32_t interval) { this->tx_interval_ = interval; }
+  void set_device_ready_timeout(uint32_t timeout) { this->device_ready_timeout_ = timeout; }
+  void set_handshake_timeout(uint32_t timeout) { this->handshake_timeout_ = timeout; }
+  void set_handshake_max_backoff(uint32_t backoff) { this->handshake_max_backoff_ = backoff; }
+  void set_resume_handshake(bool resume) { this->resume_handshake_ = resume; }
+  void set_preference_hash(uint32_t hash) { this->preference_hash_ = hash; }
+  void set_restore_state(bool restore) { this->restore_state_ = restore; }
+  void set_apply_restored_state(bool apply) { this->apply_restored_state_ = apply; }
+  void set_restore_save_delay(uint32_t delay) { this->restore_save_delay_ = delay; }
+  void set_capture_buffer_size(size_t size) { this->capture_buffer_size_ = size; }
+  void set_max_line_length(size_t length) { this->max_line_length_ = length; }
+  void set_link_timeout(uint32_t timeout) { this->link_timeout_ = timeout; }
+  void set_telemetry_interval(uint32_t interval) { this->telemetry_interval_ = interval; }
+
+  // Called with each telemetry frame, see encode_telemetry_frame for the layout
+  void add_on_telemetry_callback(std::function<void(const uint8_t *, size_t)> &&callback) {
+    this->telemetry_callback_.add(std::move(callback));
+  }
+
+  void add_aqi_control_threshold(uint16_t threshold) { this->aqi_controller_.add_threshold(threshold); }
+  void set_aqi_control_hysteresis(uint16_t hysteresis) { this->aqi_controller_.set_hysteresis(hysteresis); }
+  void set_aqi_control_min_dwell(uint32_t dwell) { this->aqi_control_min_dwell_ = dwell; }
+  void set_aqi_control_override_timeout(uint32_t timeout) { this->aqi_control_override_timeout_ = timeout; }
+
 #ifdef USE_FAN
   void set_fan(WinixC545Fan *fan) { this->fan_ = fan; };
 #endif
 
- protected:
-  const std::string RX_PREFIX{"AT*ICT*"};
-  const std::string TX_PREFIX{"*ICT*"};
+  // Keys reported by the MCU which are not built-in, defined in configuration
+#ifdef USE_SENSOR
+  void add_custom_sensor(const char *name, sensor::Sensor *sensor, float multiply);
+#endif
+#ifdef USE_SWITCH
+  void add_custom_switch(const char *name, WinixC545CustomSwitch *sw);
+#endif
+
+  // Bind an entity to a writable built-in key or a key defined in configuration
+  void add_key_entity(const char *name, WinixKeyEntity *entity);
+
+  // Find a built-in key or a key defined in configuration
+  bool find_key(const char *name, StateKey &key) const { return this->lookup_key_(pack_key(name), key); }
+
+  // Add a value for a key by name to a set of states, returns false if the key is not known
+  bool set_key_state(WinixStateMap &states, const char *name, uint16_t value) const;
+
+#ifdef USE_SENSOR
+  void set_aqi_publish_policy(uint32_t min_interval, uint32_t heartbeat, float delta, float delta_relative) {
+    this->aqi_policy_.configure(min_interval, heartbeat, delta, delta_relative);
+  }
+  void set_light_publish_policy(uint32_t min_interval, uint32_t heartbeat, float delta, float delta_relative) {
+    this->light_policy_.configure(min_interval, heartbeat, delta, delta_relative);
+  }
 
-  static constexpr uint32_t MAX_LINE_LENGTH = 128;
+  void set_diagnostics_interval(uint32_t interval) { this->diagnostics_interval_ = interval; }
 
-  static const std::unordered_map<std::string, StateKey> ENUM_KEY_MAP;
-  static const std::unordered_map<StateKey, std::string> STRING_KEY_MAP;
+  void set_aqi_statistics(uint32_t sample_interval, size_t window_size, float ema_alpha) {
+    this->aqi_statistics_.configure(sample_interval, window_size, ema_alpha);
+  }
+  void set_aqi_statistics_sensors(sensor::Sensor *mean, sensor::Sensor *min, sensor::Sensor *max, sensor::Sensor *ema, sensor::Sensor *rate) {
+    this->aqi_statistics_.set_sensors(mean, min, max, ema, rate);
+  }
+  void set_light_statistics(uint32_t sample_interval, size_t window_size, float ema_alpha) {
+    this->light_statistics_.configure(sample_interval, window_size, ema_alpha);
+  }
+  void set_light_statistics_sensors(sensor::Sensor *mean, sensor::Sensor *min, sensor::Sensor *max, sensor::Sensor *ema, sensor::Sensor *rate) {
+    this->light_statistics_.set_sensors(mean, min, max, ema, rate);
+  }
+#endif
+
+ protected:
+  // Longest sentence is an A211 command containing every writable key with a 5 digit value, plus the null terminator
+  static constexpr size_t MAX_WRITABLE_KEYS = writable_builtin_key_count() + MAX_CUSTOM_KEYS;
+  static constexpr size_t MAX_SENTENCE_LENGTH = sizeof("AWS_RECV:A211 12 {") - 1 + MAX_WRITABLE_KEYS * (sizeof("\"A02\":\"65535\",") - 1) + 1;
+
+  // Frame buffer for composing outgoing prefix, sentence and CRLF
+  char tx_buffer_[TX_PREFIX_LENGTH + MAX_SENTENCE_LENGTH + 2];
 
   enum class HandshakeState {
     Reset,
@@ -100,20 +277,222 @@ class WinixC545Component : public uart::UARTDevice, public Component {
     ApDeviceReady,
     ApStart,
     ApStop,
+    Resume,
   };
 
+  // Limits on RX processing per loop
+  uint8_t max_sentences_per_loop_{8};
+  uint32_t max_loop_time_{10};
+
+  // Commands waiting to be sent as a single A211 sentence
+  WinixStateMap pending_commands_;
+  uint32_t pending_commands_time_{0};
+  uint32_t command_coalesce_window_{50};
+
+  // Sentences waiting to be sent, drained in priority order each loop
+  WinixTxQueue tx_queue_;
+  WinixStateMap queued_commands_;  // Keys of the queued A211 command, composed when sent
+  uint32_t tx_interval_{20};
+  uint32_t last_tx_time_{0};
+
+  // Commands sent to the MCU awaiting confirmation in a state update
+  struct InflightCommand {
+    uint8_t attempts;
+    uint32_t first_sent;
+    uint32_t last_sent;
+    uint16_t previous;  // Reported value when first sent, if has_previous
+    bool has_previous;
+  };
+
+  WinixStateMap inflight_commands_;
+  InflightCommand inflight_info_[STATE_KEY_COUNT]{};
+  uint32_t command_timeout_{1000};
+  uint8_t command_retries_{2};
+  uint32_t command_retry_count_{0};
+  uint32_t command_failure_count_{0};
+
+  // Local control of fan speed from AQI, yields to manual changes for a while
+  static constexpr uint32_t AQI_CONTROL_INTERVAL = 1000;
+
+  WinixSpeedController aqi_controller_;
+  uint32_t aqi_control_min_dwell_{60000};
+  uint32_t aqi_control_override_timeout_{1800000};
+  uint32_t aqi_control_change_time_{0};
+  uint32_t aqi_control_override_time_{0};
+  bool aqi_control_override_{false};
+  uint8_t aqi_control_speed_{0};  // Speed last commanded by the controller, 0 if none
+
+  // Last states reported by the MCU, only changes are dispatched for publishing
+  WinixStateMap device_states_;
+
+  // Hash of the last payload for each of A210, A220, A230 and A240
+  uint32_t payload_hashes_[4]{};
+
+#ifdef USE_SENSOR
+  static constexpr uint32_t POLICY_CHECK_INTERVAL = 1000;
+
+  WinixPublishPolicy aqi_policy_;
+  WinixPublishPolicy light_policy_;
+
+  WinixSensorStatistics aqi_statistics_;
+  WinixSensorStatistics light_statistics_;
+
+  // Filter usage rate, in filter hours per hour, estimated from filter age increments
+  static constexpr float FILTER_RATE_SMOOTHING = 0.3f;
+
+  uint16_t filter_age_last_{0};
+  uint32_t filter_age_time_{0};
+  bool filter_age_seen_{false};
+  bool filter_age_timed_{false};
+  float filter_rate_{0};
+  int32_t filter_remaining_published_{-1};
+  int32_t filter_eta_published_{-1};
+
+  uint32_t diagnostics_interval_{0};
+#endif
+
+  // Protocol and loop statistics
+  struct ProtocolStats {
+    uint32_t rx_sentences;
+    uint32_t tx_sentences;
+    uint32_t parse_errors;
+    uint32_t unknown_api_codes;
+    uint32_t handshake_resets;
+    uint32_t last_state_time;
+
+    // Loop time in microseconds since last diagnostics publish
+    uint32_t loop_time_max;
+    uint64_t loop_time_total;
+    uint32_t loop_count;
+  };
+
+  ProtocolStats stats_{};
+
+  // Link watchdog, recovers when no valid sentence is received within the timeout
+  static constexpr uint32_t LINK_CHECK_INTERVAL = 1000;
+
+  uint32_t link_timeout_{0};
+  uint32_t last_rx_time_{0};
+  uint32_t link_recovery_time_{0};
+  uint8_t link_recoveries_{0};  // Recovery attempts since the link was lost
+  bool link_up_{false};
+
+  // Snapshots of the reported states packed into a single frame for bulk collection
+  uint32_t telemetry_interval_{0};
+  uint16_t telemetry_sequence_{0};
+  CallbackManager<void(const uint8_t *, size_t)> telemetry_callback_;
+
   HandshakeState handshake_state_{HandshakeState::Reset};
   uint32_t last_handshake_event_ = 0;
+  uint8_t handshake_failures_{0};
+
+  // Handshake timeouts, extended by exponential backoff on repeated failures
+  uint32_t device_ready_timeout_{5000};
+  uint32_t handshake_timeout_{3000};
+  uint32_t handshake_max_backoff_{60000};
+
+  // Persisted connection status for resuming after reboot
+  bool resume_handshake_{true};
+  bool handshake_saved_connected_{false};
+  uint32_t preference_hash_{0};
+  ESPPreferenceObject handshake_pref_;
+
+  // Last commanded and reported states, persisted for restore after reboot
+  struct SavedStates {
+    WinixStateMap observed;
+    WinixStateMap commanded;
+  };
+
+  bool restore_state_{true};
+  bool apply_restored_state_{false};
+  uint32_t restore_save_delay_{60000};
+  SavedStates saved_states_{};
+  bool saved_states_dirty_{false};
+  uint32_t saved_states_change_time_{0};
+  bool restore_pending_{false};
+  bool replay_pending_{false};
+  ESPPreferenceObject saved_states_pref_;
+
+  WinixStreamParser parser_;
+  size_t max_line_length_{WinixStreamParser::DEFAULT_MAX_LINE_LENGTH};
+
+  // Bytes read from the UART in bulk which have not been parsed yet
+  uint8_t rx_chunk_[64];
+  uint8_t rx_chunk_position_{0};
+  uint8_t rx_chunk_length_{0};
+
+  // Capture of raw RX and TX lines for field debugging
+  WinixCaptureBuffer capture_;
+  size_t capture_buffer_size_{0};
+  bool replaying_{false};
+
+  // Keys defined in configuration, in addition to the built-in keys
+  struct CustomKey {
+    uint32_t packed_key;
+    char name[4];
+    bool writable;
+#ifdef USE_SENSOR
+    sensor::Sensor *sensor;
+    float multiply;
+#endif
+#ifdef USE_SWITCH
+    WinixC545CustomSwitch *sw;
+#endif
+  };
+
+  CustomKey custom_keys_[MAX_CUSTOM_KEYS]{};
+  uint8_t custom_key_count_{0};
+
+  // Entities bound to keys by configuration, updated with each reported value
+  static constexpr size_t MAX_KEY_ENTITIES = 16;
+
+  WinixKeyEntity *key_entities_[MAX_KEY_ENTITIES]{};
+  uint8_t key_entity_count_{0};
 
   WinixStateMap states_;
   uint32_t aqi_indicator_raw_value_ = 0;
 
   void update_handshake_state_();
-  bool readline_(char, char *, int);
-  void parse_sentence_(char *);
+  void check_link_();
+  void set_link_state_(bool);
+  void invalidate_states_();
+  void publish_telemetry_();
+  void set_handshake_state_(HandshakeState);
+  uint32_t handshake_backoff_(uint32_t) const;
+  void handshake_failed_();
+  bool read_sentence_();
+  void parse_sentence_(WinixStreamParser &);
   void parse_aws_sentence_(char *);
+  bool parse_payload_(const char *);
+  bool add_custom_key_(const char *, bool, StateKey &);
+  bool lookup_key_(uint32_t, StateKey &) const;
+  const char *key_name_(StateKey) const;
+  bool is_writable_key_(StateKey) const;
   void publish_state_();
-  void write_sentence_(const std::string &);
+  void publish_custom_state_(StateKey, uint16_t);
+  void update_inflight_commands_();
+  static bool is_persisted_key_(StateKey);
+  void mark_saved_states_dirty_();
+  void save_states_();
+  void restore_states_();
+  void replay_states_();
+  void check_inflight_timeouts_();
+#ifdef USE_SENSOR
+  void publish_policy_sensors_();
+  void publish_diagnostics_();
+  void update_filter_rate_(uint16_t);
+  void publish_filter_sensors_();
+  void setup_statistics_(WinixSensorStatistics &, const char *, StateKey);
+#endif
+  void update_aqi_control_();
+  void pause_aqi_control_();
+  void queue_commands_(const WinixStateMap &);
+  void flush_commands_();
+  void write_commands_(const WinixStateMap &);
+  void write_sentence_(const char *);
+  void write_sentence_(const char *, size_t);
+  void queue_sentence_(TxPriority, const char *);
+  void drain_tx_queue_();
 
 #ifdef USE_FAN
   WinixC545Fan *fan_{nullptr};
@@ -135,24 +514,52 @@ class WinixC545Fan : public fan::Fan, public Parented<WinixC545Component> {
   void update_state(const WinixStateMap &);
 
  protected:
-  const std::string PRESET_NONE{""};
-  const std::string PRESET_SLEEP{"Sleep"};
-  const std::string PRESET_AUTO{"Auto"};
+  static constexpr const char *PRESET_NONE = "";
+  static constexpr const char *PRESET_SLEEP = "Sleep";
+  static constexpr const char *PRESET_AUTO = "Auto";
+
+  // Device speed values
+  static constexpr uint8_t SPEED_TURBO = 5;
+  static constexpr uint8_t SPEED_SLEEP = 6;
+
+  enum class Preset : uint8_t {
+    None,
+    Sleep,
+    Auto,
+  };
+
+  // Mapping of device speed values to fan speed and preset
+  struct SpeedMapping {
+    uint8_t value;
+    uint8_t speed;
+    Preset preset;
+  };
+
+  static const SpeedMapping SPEED_MAP[];
+
+  static const char *preset_to_string_(Preset);
+  static Preset preset_from_string_(const std::string &);
+  static const SpeedMapping *speed_from_value_(uint16_t);
+  static uint8_t value_from_speed_(int);
+  void set_preset_(Preset);
 
   void control(const fan::FanCall &call) override;
   fan::FanTraits traits_;
+  Preset preset_{Preset::None};
 };
 
 class WinixC545Switch : public switch_::Switch, public Parented<WinixC545Component> {
  public:
   WinixC545Switch(StateKey key, uint8_t on_value = 1, uint8_t off_value = 0) : key_(key), on_value_(on_value), off_value_(off_value) {}
 
+  uint8_t get_on_value() const { return this->on_value_; }
+
  protected:
   void write_state(bool state) override;
 
-  const StateKey key_;
-  const uint8_t on_value_;
-  const uint8_t off_value_;
+  StateKey key_;
+  uint8_t on_value_;
+  uint8_t off_value_;
 };
 
 class WinixC545PlasmawaveSwitch : public WinixC545Switch {
@@ -160,5 +567,65 @@ class WinixC545PlasmawaveSwitch : public WinixC545Switch {
   WinixC545PlasmawaveSwitch() : WinixC545Switch(StateKey::Plasmawave) {}
 };
 
+// Switch for a key defined in configuration, the key is assigned when registered with the component
+class WinixC545CustomSwitch : public WinixC545Switch {
+ public:
+  WinixC545CustomSwitch() : WinixC545Switch(StateKey::Custom) {}
+
+  void set_key(StateKey key) { this->key_ = key; }
+  void set_values(uint8_t on_value, uint8_t off_value) {
+    this->on_value_ = on_value;
+    this->off_value_ = off_value;
+  }
+};
+
+// Entity bound to a single key, updated when the MCU reports its value
+class WinixKeyEntity : public Parented<WinixC545Component> {
+ public:
+  void set_key(StateKey key) { this->key_ = key; }
+  StateKey get_key() const { return this->key_; }
+
+  virtual void update_value(uint16_t value) = 0;
+
+ protected:
+  void write_value_(uint16_t value);
+
+  StateKey key_{StateKey::Custom};
+};
+
+#ifdef USE_SELECT
+// Select writing the value associated with each option
+class WinixC545Select : public select::Select, public WinixKeyEntity {
+ public:
+  static constexpr size_t MAX_OPTIONS = 16;
+
+  void add_value(uint16_t value) {
+    if (this->value_count_ < MAX_OPTIONS)
+      this->values_[this->value_count_++] = value;
+  }
+
+  void update_value(uint16_t value) override;
+
+ protected:
+  void control(const std::string &value) override;
+
+  // Key values, in the order of the options
+  uint16_t values_[MAX_OPTIONS]{};
+  size_t value_count_{0};
+  int32_t unmatched_value_{-1};  // Last reported value without an option, -1 if none
+};
+#endif
+
+#ifdef USE_NUMBER
+// Number writing its value directly to a key
+class WinixC545Number : public number::Number, public WinixKeyEntity {
+ public:
+  void update_value(uint16_t value) override;
+
+ protected:
+  void control(float value) override;
+};
+#endif
+
 }  // namespace winix_c545
 }  // namespace esphome
\ No newline at end of file
@@ -0,0 +1,146 @@
+// Throughput, worst-case loop time and allocations of the receive path, from the UART through the loop to
+// published entities, for state updates and for malformed lines
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "purifier.h"
+
+using esphome::winix_c545::testing::Purifier;
+
+namespace {
+
+// Allocations are only counted while the component runs
+bool counting = false;
+size_t allocation_count = 0;
+size_t allocation_bytes = 0;
+
+}  // namespace
+
+void *operator new(size_t size) {
+  if (counting) {
+    allocation_count++;
+    allocation_bytes += size;
+  }
+
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t size) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t size) noexcept { free(ptr); }
+
+namespace {
+
+struct Result {
+  size_t frames;
+  double seconds;
+  double max_loop_time;  // Microseconds
+  size_t allocations;
+  size_t allocation_bytes;
+};
+
+// Feed the lines in turn, running the loop once for each
+Result replay(Purifier &purifier, const std::vector<std::string> &lines, size_t frames) {
+  // Warm up so buffers reach their steady state size
+  for (const auto &line : lines) {
+    purifier.uart.inject(line);
+    purifier.component.loop();
+    purifier.uart.take_tx();
+    esphome::testing::advance(1);
+  }
+
+  allocation_count = allocation_bytes = 0;
+  Result result{frames, 0, 0, 0, 0};
+  for (size_t i = 0; i < frames; i++) {
+    purifier.uart.inject(lines[i % lines.size()]);
+
+    const auto start = std::chrono::steady_clock::now();
+    counting = true;
+    purifier.component.loop();
+    counting = false;
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.seconds += time;
+    result.max_loop_time = std::max(result.max_loop_time, time * 1e6);
+
+    // Discard the acknowledgements
+    purifier.uart.take_tx();
+    esphome::testing::advance(1);
+  }
+
+  result.allocations = allocation_count;
+  result.allocation_bytes = allocation_bytes;
+  return result;
+}
+
+void report(const char *name, const Result &result) {
+  printf("%s\n", name);
+  printf("  Frames:          %zu\n", result.frames);
+  printf("  Frames/sec:      %.0f\n", result.frames / result.seconds);
+  printf("  Time/frame:      %.0f ns\n", result.seconds * 1e9 / result.frames);
+  printf("  Max loop time:   %.1f us\n", result.max_loop_time);
+  printf("  Allocations:     %zu (%zu bytes, %.3f per frame)\n", result.allocations, result.allocation_bytes, double(result.allocations) / result.frames);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const size_t frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+
+  Purifier purifier;
+  purifier.start();
+
+  // Sensor updates with changing values, and a full state update every tenth frame
+  std::vector<std::string> lines;
+  for (int i = 0; i < 100; i++) {
+    const std::string aqi = std::to_string(20 + i % 60);
+    const std::string light = std::to_string(100 + i);
+    if (i % 10 == 0) {
+      lines.push_back("AT*ICT*AWS_SEND=A210 {\"A02\":\"1\",\"A03\":\"0\",\"A04\":\"1\",\"A05\":\"01\",\"A07\":\"1\",\"A21\":\"" + std::to_string(1000 + i) + "\",\"S07\":\"01\",\"S08\":\"" + aqi + "\",\"S14\":\"" + light + "\"}\r\n");
+    } else {
+      lines.push_back("AT*ICT*AWS_SEND=A220 {\"S07\":\"01\",\"S08\":\"" + aqi + "\",\"S14\":\"" + light + "\"}\r\n");
+    }
+  }
+
+  // Overlong, truncated and non-prefixed lines between valid sensor updates
+  std::vector<std::string> garbage;
+  for (int i = 0; i < 100; i++) {
+    const std::string valid = lines[1 + i % 9];
+    switch (i % 4) {
+      case 0:
+        garbage.push_back("AT*ICT*AWS_SEND=A210 {\"A02\":\"" + std::string(200 + i, '1') + "\"}\r\n");
+        break;
+      case 1:
+        garbage.push_back(valid.substr(0, 10 + i % (valid.size() - 12)) + "\r\n");
+        break;
+      case 2:
+        garbage.push_back(std::string(1 + i % 40, static_cast<char>('!' + i % 90)) + valid.substr(7));
+        break;
+      case 3:
+        garbage.push_back(valid);
+        break;
+    }
+  }
+
+  const Result updates = replay(purifier, lines, frames);
+  report("State updates", updates);
+  const Result malformed = replay(purifier, garbage, frames);
+  report("Malformed lines", malformed);
+
+  // The receive path must not allocate once running
+  if (updates.allocations != 0 || malformed.allocations != 0) {
+    printf("FAIL: allocations in steady state\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+// Standalone driver for the fuzz target, for compilers without libFuzzer. Replays the given files
+// and deterministic mutations of them, and checks the worst-case CPU time of an input.
+//
+// Usage: winix_c545_fuzz [-runs=N] [-max_time_us=N] [file or directory...]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+
+constexpr size_t MAX_INPUT_SIZE = 1024;
+
+// Bytes which are significant to the parser
+constexpr char SPECIAL_BYTES[] = "\"{},:=*ATICS0123456789 \r\n\x00\x7f\xff";
+
+// xorshift32, so runs are reproducible
+uint32_t next_random(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+std::string mutate(const std::vector<std::string> &seeds, uint32_t &random) {
+  std::string input = seeds[next_random(random) % seeds.size()];
+
+  const uint32_t mutations = 1 + next_random(random) % 4;
+  for (uint32_t i = 0; i < mutations; i++) {
+    const size_t position = input.empty() ? 0 : next_random(random) % input.size();
+    switch (next_random(random) % 7) {
+      case 0:  // Replace a byte
+        if (!input.empty())
+          input[position] = static_cast<char>(next_random(random));
+        break;
+      case 1:  // Insert a significant byte
+        input.insert(position, 1, SPECIAL_BYTES[next_random(random) % (sizeof(SPECIAL_BYTES) - 1)]);
+        break;
+      case 2:  // Delete a range
+        input.erase(position, 1 + next_random(random) % 8);
+        break;
+      case 3:  // Truncate
+        input.resize(position);
+        break;
+      case 4:  // Repeat a range, producing long lines
+        input.insert(position, input.substr(position, 1 + next_random(random) % 64));
+        break;
+      case 5: {  // Splice with the end of another seed
+        const std::string &other = seeds[next_random(random) % seeds.size()];
+        input = input.substr(0, position) + other.substr(other.empty() ? 0 : next_random(random) % other.size());
+        break;
+      }
+      case 6:  // Replace a digit, keeping the structure
+        if (!input.empty() && isdigit(static_cast<unsigned char>(input[position])))
+          input[position] = '0' + next_random(random) % 10;
+        break;
+    }
+  }
+
+  if (input.size() > MAX_INPUT_SIZE)
+    input.resize(MAX_INPUT_SIZE);
+  return input;
+}
+
+// CPU time of a single run of the target, in microseconds
+double run(const std::string &input) {
+  timespec start, end;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+  LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+  return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+void load(const std::filesystem::path &path, std::vector<std::string> &seeds) {
+  if (std::filesystem::is_directory(path)) {
+    // Sorted, so runs are reproducible
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::directory_iterator(path))
+      files.push_back(entry.path());
+    std::sort(files.begin(), files.end());
+    for (const auto &file : files)
+      load(file, seeds);
+    return;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  seeds.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  size_t runs = 100000;
+  double max_time = 5000;
+  std::vector<std::string> seeds;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "-runs=", 6) == 0) {
+      runs = strtoul(argv[i] + 6, nullptr, 10);
+    } else if (strncmp(argv[i], "-max_time_us=", 13) == 0) {
+      max_time = strtod(argv[i] + 13, nullptr);
+    } else {
+      load(argv[i], seeds);
+    }
+  }
+
+  if (seeds.empty())
+    seeds.emplace_back();
+
+  // Seeds first, then mutations. The slowest inputs are kept for timing
+  constexpr size_t SLOWEST_COUNT = 16;
+  std::vector<std::pair<double, std::string>> slowest;
+  uint32_t random = 0x2545F491;
+  for (size_t i = 0; i < seeds.size() + runs; i++) {
+    std::string input = i < seeds.size() ? seeds[i] : mutate(seeds, random);
+    const double time = run(input);
+
+    if (slowest.size() < SLOWEST_COUNT || time > slowest.back().first) {
+      if (slowest.size() == SLOWEST_COUNT)
+        slowest.pop_back();
+      slowest.emplace_back(time, std::move(input));
+      std::sort(slowest.begin(), slowest.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    }
+  }
+
+  // Single runs are noisy, time the slowest inputs again and take the best of three
+  double worst = 0;
+  std::string worst_input;
+  for (const auto &entry : slowest) {
+    const double time = std::min({run(entry.second), run(entry.second), run(entry.second)});
+    if (time > worst) {
+      worst = time;
+      worst_input = entry.second;
+    }
+  }
+
+  printf("Inputs:            %zu\n", seeds.size() + runs);
+  printf("Worst CPU time:    %.1f us for %zu bytes\n", worst, worst_input.size());
+
+  if (worst > max_time) {
+    printf("FAIL: worst CPU time exceeds %.0f us\n", max_time);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+// Fuzz target for the receive path, from the UART through the loop to published entities.
+// Each CR terminated line is checked against an independent decoder: a line must be acknowledged
+// exactly when it is a well-formed sentence, and must either apply all of its states or none of them
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+
+#include "purifier.h"
+
+using esphome::winix_c545::WinixStreamParser;
+using esphome::winix_c545::testing::Purifier;
+
+namespace {
+
+enum class Reference {
+  Invalid,
+  Disconnect,  // A102, acknowledged without a payload
+  State,
+};
+
+// Strict decoder of AWS_SEND sentences, written from the protocol rather than the component
+Reference decode(std::string line, std::map<std::string, uint32_t> &values) {
+  // New-lines are ignored by the stream parser, lines which don't fit are dropped
+  std::string filtered;
+  for (const char c : line) {
+    if (c != '\n')
+      filtered += c;
+  }
+  if (filtered.size() >= WinixStreamParser::DEFAULT_MAX_LINE_LENGTH)
+    return Reference::Invalid;
+
+  // The line is a C string
+  line = filtered.substr(0, filtered.find('\0'));
+
+  const std::string prefix = "AT*ICT*AWS_SEND=A";
+  if (line.compare(0, prefix.size(), prefix) != 0 || line.size() < prefix.size() + 3)
+    return Reference::Invalid;
+
+  const std::string code = line.substr(prefix.size(), 3);
+  if (code.find_first_not_of("0123456789") != std::string::npos)
+    return Reference::Invalid;
+  if (code == "102")
+    return Reference::Disconnect;
+  if (code != "210" && code != "220" && code != "230" && code != "240")
+    return Reference::Invalid;
+
+  // Payload of one or more "KEY":"VALUE" pairs in braces, ending the line
+  size_t position = line.find('{', prefix.size() + 3);
+  if (position == std::string::npos)
+    return Reference::Invalid;
+  position++;
+
+  static const char *const KNOWN_KEYS[] = {"A02", "A03", "A04", "A07", "A21", "P01", "S07", "S08", "S14"};
+  while (true) {
+    if (line.size() < position + 7 || line[position] != '"' || line[position + 4] != '"' || line[position + 5] != ':' || line[position + 6] != '"')
+      return Reference::Invalid;
+
+    const std::string key = line.substr(position + 1, 3);
+    const size_t value_end = line.find('"', position + 7);
+    if (value_end == std::string::npos)
+      return Reference::Invalid;
+    const std::string value = line.substr(position + 7, value_end - position - 7);
+    position = value_end + 1;
+
+    bool known = false;
+    for (const char *known_key : KNOWN_KEYS)
+      known |= key == known_key;
+
+    // Known keys have decimal values, saturated to 16 bits
+    if (known) {
+      if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+        return Reference::Invalid;
+
+      uint32_t number = 0;
+      for (const char digit : value)
+        number = std::min<uint32_t>(number * 10 + (digit - '0'), UINT16_MAX);
+      values[key] = number;
+    }
+
+    if (position < line.size() && line[position] == ',') {
+      position++;
+      continue;
+    }
+
+    return position + 1 == line.size() && line[position] == '}' ? Reference::State : Reference::Invalid;
+  }
+}
+
+// Publishes of all entities, any change shows a state was applied
+int publish_count(const Purifier &purifier) {
+  return purifier.aqi.publish_count + purifier.light.publish_count + purifier.filter_age.publish_count + purifier.filter_lifetime.publish_count + purifier.fan.publish_count;
+}
+
+// Created once and kept across inputs, like the component on a device
+Purifier &connected_purifier() {
+  static Purifier *purifier = nullptr;
+  if (purifier == nullptr) {
+    purifier = new Purifier();
+    purifier->start();
+  }
+  return *purifier;
+}
+
+void fail(const char *reason, const std::string &line) {
+  fprintf(stderr, "%s: ", reason);
+  for (const char c : line)
+    fprintf(stderr, c >= ' ' && c <= '~' ? "%c" : "\\x%02x", static_cast<uint8_t>(c));
+  fprintf(stderr, "\n");
+  abort();
+}
+
+void check_line(Purifier &purifier, const std::string &line) {
+  const int publishes = publish_count(purifier);
+
+  purifier.uart.inject(line + "\r");
+  do {
+    purifier.component.loop();
+  } while (purifier.uart.available() != 0);
+
+  // Replies are discarded, the MCU is not simulated while fuzzing
+  const bool acked = purifier.uart.take_tx().find("*ICT*AWS_SEND:OK\r\n") != std::string::npos;
+  esphome::testing::advance(1);
+
+  std::map<std::string, uint32_t> values;
+  const Reference reference = decode(line, values);
+
+  if (acked != (reference != Reference::Invalid))
+    fail(acked ? "Malformed line was acknowledged" : "Valid line was not acknowledged", line);
+
+  if (!acked && publish_count(purifier) != publishes)
+    fail("Line was not acknowledged but changed published state", line);
+
+  // Every state of an accepted frame is applied
+  const std::pair<const char *, const esphome::sensor::Sensor *> sensors[] = {
+      {"S08", &purifier.aqi},
+      {"S14", &purifier.light},
+      {"A21", &purifier.filter_age},
+      {"P01", &purifier.filter_lifetime},
+  };
+  for (const auto &sensor : sensors) {
+    if (reference == Reference::State && values.count(sensor.first) != 0 && sensor.second->state != values[sensor.first])
+      fail("State of an accepted line was not applied", line);
+  }
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  Purifier &purifier = connected_purifier();
+
+  // Check each line of the input separately
+  const std::string input(reinterpret_cast<const char *>(data), size);
+  size_t start = 0;
+  while (true) {
+    const size_t end = input.find('\r', start);
+    check_line(purifier, input.substr(start, end == std::string::npos ? std::string::npos : end - start));
+    if (end == std::string::npos)
+      break;
+    start = end + 1;
+  }
+
+  return 0;
+}
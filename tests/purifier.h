@@ -0,0 +1,67 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "simulator.h"
+#include "winix_c545.h"
+
+namespace esphome {
+namespace winix_c545 {
+namespace testing {
+
+// Component wired to a simulated MCU with the commonly configured entities, as generated code would
+struct Purifier {
+  Purifier() {
+    this->component.set_uart_parent(&this->uart);
+    this->fan.set_parent(&this->component);
+    this->component.set_fan(&this->fan);
+    this->component.set_aqi_sensor(&this->aqi);
+    this->component.set_light_sensor(&this->light);
+    this->component.set_filter_age_sensor(&this->filter_age);
+    this->component.set_filter_lifetime_sensor(&this->filter_lifetime);
+    this->component.set_link_binary_sensor(&this->link);
+  }
+
+  // Call setup and run until the handshake completes
+  void start(uint32_t timeout = 2000) {
+    this->component.setup();
+    this->run_until([this]() { return this->mcu.is_connected() && this->uart.available() == 0; }, timeout);
+    this->run(100);
+  }
+
+  // Run the main loop and the MCU for a duration, in steps of 16ms like the ESPHome main loop
+  void run(uint32_t duration, uint32_t step = 16) {
+    for (uint32_t elapsed = 0; elapsed < duration; elapsed += step)
+      this->step(step);
+  }
+
+  // Run until a condition holds, returns false on timeout
+  template <typename Condition>
+  bool run_until(Condition condition, uint32_t timeout, uint32_t step = 16) {
+    for (uint32_t elapsed = 0; elapsed < timeout; elapsed += step) {
+      if (condition())
+        return true;
+      this->step(step);
+    }
+    return condition();
+  }
+
+  void step(uint32_t step) {
+    this->component.loop();
+    this->mcu.process();
+    esphome::testing::advance(step);
+  }
+
+  FakeUART uart;
+  McuSimulator mcu{uart};
+  WinixC545Component component;
+  WinixC545Fan fan;
+  sensor::Sensor aqi;
+  sensor::Sensor light;
+  sensor::Sensor filter_age;
+  sensor::Sensor filter_lifetime;
+  binary_sensor::BinarySensor link;
+};
+
+}  // namespace testing
+}  // namespace winix_c545
+}  // namespace esphome
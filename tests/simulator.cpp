@@ -0,0 +1,126 @@
+#include "simulator.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace winix_c545 {
+namespace testing {
+
+void FakeUART::write_array(const uint8_t *data, size_t len) { this->tx_.append(reinterpret_cast<const char *>(data), len); }
+
+bool FakeUART::read_array(uint8_t *data, size_t len) {
+  if (len > this->rx_.size() - this->rx_position_)
+    return false;
+
+  memcpy(data, this->rx_.data() + this->rx_position_, len);
+  this->rx_position_ += len;
+
+  // Drop consumed bytes once everything has been read
+  if (this->rx_position_ == this->rx_.size()) {
+    this->rx_.clear();
+    this->rx_position_ = 0;
+  }
+  return true;
+}
+
+void FakeUART::inject(const std::string &data) { this->rx_ += data; }
+
+std::string FakeUART::take_tx() {
+  // Copy rather than swap, so writes from the component reuse the buffer without allocating
+  std::string tx = this->tx_;
+  this->tx_.clear();
+  return tx;
+}
+
+McuSimulator::McuSimulator(FakeUART &uart) : uart_(uart) {
+  // Typical state of a purifier running at low speed
+  this->states_ = {
+      {"A02", "1"},
+      {"A03", "0"},
+      {"A04", "1"},
+      {"A05", "01"},
+      {"A07", "1"},
+      {"A21", "1000"},
+      {"S07", "01"},
+      {"S08", "50"},
+      {"S14", "30"},
+  };
+}
+
+void McuSimulator::send(const std::string &sentence) { this->uart_.inject("AT*ICT*" + sentence + "\r\n"); }
+
+void McuSimulator::send_state() {
+  std::string payload;
+  for (const auto &state : this->states_) {
+    if (state.first == "P01")
+      continue;
+    payload += (payload.empty() ? "{" : ",") + ("\"" + state.first + "\":\"" + state.second + "\"");
+  }
+  this->send("AWS_SEND=A210 " + payload + "}");
+}
+
+void McuSimulator::send_sensors() {
+  this->send("AWS_SEND=A220 {\"S07\":\"" + this->states_["S07"] + "\",\"S08\":\"" + this->states_["S08"] + "\",\"S14\":\"" + this->states_["S14"] + "\"}");
+}
+
+size_t McuSimulator::count_received(const std::string &sentence) const { return std::count(this->received_.begin(), this->received_.end(), sentence); }
+
+void McuSimulator::process() {
+  this->partial_ += this->uart_.take_tx();
+
+  size_t end;
+  while ((end = this->partial_.find("\r\n")) != std::string::npos) {
+    const std::string line = this->partial_.substr(0, end);
+    this->partial_.erase(0, end + 2);
+
+    if (line.compare(0, 5, "*ICT*") != 0) {
+      this->malformed_count_++;
+      continue;
+    }
+
+    const std::string sentence = line.substr(5);
+    this->received_.push_back(sentence);
+    if (!this->silent_)
+      this->handle_(sentence);
+  }
+}
+
+void McuSimulator::handle_(const std::string &sentence) {
+  if (sentence == "DEVICEREADY") {
+    this->connected_ = false;
+    this->send("MCU_READY=1.2.0");
+  } else if (sentence == "MCU_READY:OK") {
+    this->send("MIB=32");
+  } else if (sentence == "AWS_IND:CONNECT OK") {
+    // Connection indication, the MCU reports its full state
+    this->connected_ = true;
+    this->send_state();
+    this->send("AWS_SEND=A240 {\"P01\":\"6480\"}");
+  } else if (sentence.compare(0, 18, "AWS_RECV:A211 12 {") == 0) {
+    if (this->apply_commands_)
+      this->apply_command_(sentence.substr(17));
+  }
+}
+
+void McuSimulator::apply_command_(const std::string &payload) {
+  // Payload is of the form {"A02":"1","A04":"3"}
+  size_t position = 0;
+  while ((position = payload.find('"', position)) != std::string::npos) {
+    const size_t key_end = payload.find('"', position + 1);
+    const size_t value_start = payload.find('"', key_end + 1);
+    const size_t value_end = payload.find('"', value_start + 1);
+    if (key_end == std::string::npos || value_start == std::string::npos || value_end == std::string::npos)
+      break;
+
+    this->states_[payload.substr(position + 1, key_end - position - 1)] = payload.substr(value_start + 1, value_end - value_start - 1);
+    position = value_end + 1;
+  }
+
+  // Confirm the change with a state update
+  this->send_state();
+}
+
+}  // namespace testing
+}  // namespace winix_c545
+}  // namespace esphome
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esphome/components/uart/uart.h"
+
+namespace esphome {
+namespace winix_c545 {
+namespace testing {
+
+// UART connecting the component to a simulated MCU
+class FakeUART : public uart::UARTComponent {
+ public:
+  void write_array(const uint8_t *data, size_t len) override;
+  bool read_array(uint8_t *data, size_t len) override;
+  int available() override { return this->rx_.size() - this->rx_position_; }
+  void load_settings(bool dump_config) override { this->reload_count_++; }
+
+  // Queue bytes sent by the MCU to the component
+  void inject(const std::string &data);
+
+  // Remove and return the bytes written by the component
+  std::string take_tx();
+
+  size_t get_reload_count() const { return this->reload_count_; }
+
+ protected:
+  std::string rx_;
+  size_t rx_position_{0};
+  std::string tx_;
+  size_t reload_count_{0};
+};
+
+// Scripted MCU of a C545, handling the handshake and A211 commands like the real device
+class McuSimulator {
+ public:
+  explicit McuSimulator(FakeUART &uart);
+
+  // Values reported in A210 state updates
+  void set_state(const std::string &key, const std::string &value) { this->states_[key] = value; }
+  const std::string &get_state(const std::string &key) { return this->states_[key]; }
+  void erase_state(const std::string &key) { this->states_.erase(key); }
+
+  // Send a sentence, the RX prefix and CR are added
+  void send(const std::string &sentence);
+  // Send a full A210 state update
+  void send_state();
+  // Send an A220 sensor update
+  void send_sensors();
+
+  // Reply to the sentences written by the component since the last call
+  void process();
+
+  // Sentences written by the component in order, without the TX prefix and CRLF
+  const std::vector<std::string> &get_received() const { return this->received_; }
+  size_t count_received(const std::string &sentence) const;
+  void clear_received() { this->received_.clear(); }
+
+  // Lines which did not have the TX prefix and CRLF
+  size_t get_malformed_count() const { return this->malformed_count_; }
+
+  bool is_connected() const { return this->connected_; }
+
+  // Apply A211 commands and confirm them in a state update, otherwise they are ignored
+  void set_apply_commands(bool apply) { this->apply_commands_ = apply; }
+  // Stop replying to anything, as if the MCU had hung
+  void set_silent(bool silent) { this->silent_ = silent; }
+
+ protected:
+  void handle_(const std::string &sentence);
+  void apply_command_(const std::string &payload);
+
+  FakeUART &uart_;
+  std::map<std::string, std::string> states_;
+  std::vector<std::string> received_;
+  std::string partial_;
+  size_t malformed_count_{0};
+  bool connected_{false};
+  bool apply_commands_{true};
+  bool silent_{false};
+};
+
+}  // namespace testing
+}  // namespace winix_c545
+}  // namespace esphome
@@ -0,0 +1,103 @@
+// Host implementation of the ESPHome core functions used by the component
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+
+namespace {
+
+struct Interval {
+  Component *component;
+  std::string name;
+  uint32_t interval;
+  uint32_t next;
+  std::function<void()> callback;
+};
+
+// Start after boot, a millis() of 0 is used by the component as "never"
+uint64_t now_us = 1000000;
+std::vector<Interval> intervals;
+ESPPreferences preferences;
+
+}  // namespace
+
+ESPPreferences *global_preferences = &preferences;
+
+uint32_t millis() { return now_us / 1000; }
+uint32_t micros() { return now_us; }
+
+std::string format_hex(const uint8_t *data, size_t length) {
+  static const char DIGITS[] = "0123456789abcdef";
+  std::string hex;
+  for (size_t i = 0; i < length; i++) {
+    hex += DIGITS[data[i] >> 4];
+    hex += DIGITS[data[i] & 0x0F];
+  }
+  return hex;
+}
+
+Component::~Component() {
+  for (auto it = intervals.begin(); it != intervals.end();) {
+    if (it->component == this)
+      it = intervals.erase(it);
+    else
+      ++it;
+  }
+}
+
+void Component::set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {
+  // Replace an interval of the same name, as the ESPHome scheduler does
+  for (auto &existing : intervals) {
+    if (existing.component == this && existing.name == name) {
+      existing = {this, name, interval, millis() + interval, std::move(f)};
+      return;
+    }
+  }
+
+  intervals.push_back({this, name, interval, millis() + interval, std::move(f)});
+}
+
+namespace testing {
+
+size_t warning_count = 0;
+
+bool log_enabled() {
+  static const bool ENABLED = getenv("WINIX_TEST_LOG") != nullptr;
+  return ENABLED;
+}
+
+void advance(uint32_t ms) {
+  const uint64_t end = now_us + uint64_t(ms) * 1000;
+  while (true) {
+    // Run the earliest due interval, or stop once none is due before the end
+    Interval *due = nullptr;
+    for (auto &interval : intervals) {
+      if (interval.interval != 0 && uint64_t(interval.next) * 1000 <= end && (due == nullptr || interval.next < due->next))
+        due = &interval;
+    }
+
+    if (due == nullptr)
+      break;
+
+    if (uint64_t(due->next) * 1000 > now_us)
+      now_us = uint64_t(due->next) * 1000;
+    due->next += due->interval;
+
+    // The callback may add intervals, invalidating the pointer
+    const std::function<void()> callback = due->callback;
+    callback();
+  }
+
+  now_us = end;
+}
+
+}  // namespace testing
+}  // namespace esphome
@@ -0,0 +1,25 @@
+#pragma once
+
+namespace esphome {
+namespace binary_sensor {
+
+class BinarySensor {
+ public:
+  void publish_state(bool state) {
+    this->state = state;
+    this->publish_count++;
+  }
+
+  bool state{false};
+  int publish_count{0};
+};
+
+}  // namespace binary_sensor
+}  // namespace esphome
+
+#define SUB_BINARY_SENSOR(name)                                         \
+ protected:                                                             \
+  esphome::binary_sensor::BinarySensor *name##_binary_sensor_{nullptr}; \
+                                                                        \
+ public:                                                                \
+  void set_##name##_binary_sensor(esphome::binary_sensor::BinarySensor *sensor) { this->name##_binary_sensor_ = sensor; }
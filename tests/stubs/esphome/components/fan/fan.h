@@ -0,0 +1,62 @@
+#pragma once
+
+#include <initializer_list>
+#include <string>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace fan {
+
+class FanTraits {
+ public:
+  FanTraits() {}
+  FanTraits(bool oscillation, bool speed, bool direction, int speed_count) {}
+
+  void set_supported_preset_modes(std::initializer_list<const char *> preset_modes) {}
+};
+
+class FanCall {
+ public:
+  FanCall &set_state(bool state) {
+    this->state_ = state;
+    return *this;
+  }
+  FanCall &set_speed(int speed) {
+    this->speed_ = speed;
+    return *this;
+  }
+  FanCall &set_preset_mode(const std::string &preset_mode) {
+    this->preset_mode_ = preset_mode;
+    return *this;
+  }
+
+  optional<bool> get_state() const { return this->state_; }
+  optional<int> get_speed() const { return this->speed_; }
+  const std::string &get_preset_mode() const { return this->preset_mode_; }
+
+ protected:
+  optional<bool> state_;
+  optional<int> speed_;
+  std::string preset_mode_;
+};
+
+class Fan {
+ public:
+  virtual ~Fan() {}
+  virtual FanTraits get_traits() = 0;
+
+  void perform(const FanCall &call) { this->control(call); }
+  void publish_state() { this->publish_count++; }
+
+  bool state{false};
+  int speed{0};
+  std::string preset_mode;
+  int publish_count{0};
+
+ protected:
+  virtual void control(const FanCall &call) = 0;
+};
+
+}  // namespace fan
+}  // namespace esphome
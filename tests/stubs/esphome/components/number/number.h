@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cmath>
+
+namespace esphome {
+namespace number {
+
+class Number {
+ public:
+  virtual ~Number() {}
+
+  void make_call(float value) { this->control(value); }
+  void publish_state(float state) { this->state = state; }
+
+  float state{NAN};
+
+ protected:
+  virtual void control(float value) = 0;
+};
+
+}  // namespace number
+}  // namespace esphome
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+namespace select {
+
+class SelectTraits {
+ public:
+  void set_options(std::vector<std::string> options) { this->options_ = std::move(options); }
+  const std::vector<std::string> &get_options() const { return this->options_; }
+
+ protected:
+  std::vector<std::string> options_;
+};
+
+class Select {
+ public:
+  virtual ~Select() {}
+
+  void make_call(const std::string &value) { this->control(value); }
+  void publish_state(const std::string &state) { this->state = state; }
+
+  std::string state;
+  SelectTraits traits;
+
+ protected:
+  virtual void control(const std::string &value) = 0;
+};
+
+}  // namespace select
+}  // namespace esphome
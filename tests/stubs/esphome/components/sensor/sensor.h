@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cmath>
+
+namespace esphome {
+namespace sensor {
+
+class Sensor {
+ public:
+  void publish_state(float state) {
+    this->state = state;
+    this->raw_state = state;
+    this->publish_count++;
+  }
+
+  float state{NAN};
+  float raw_state{NAN};
+  int publish_count{0};
+};
+
+}  // namespace sensor
+}  // namespace esphome
+
+#define SUB_SENSOR(name)                            \
+ protected:                                         \
+  esphome::sensor::Sensor *name##_sensor_{nullptr}; \
+                                                    \
+ public:                                            \
+  void set_##name##_sensor(esphome::sensor::Sensor *sensor) { this->name##_sensor_ = sensor; }
@@ -0,0 +1,29 @@
+#pragma once
+
+namespace esphome {
+namespace switch_ {
+
+class Switch {
+ public:
+  virtual ~Switch() {}
+
+  void turn_on() { this->write_state(true); }
+  void turn_off() { this->write_state(false); }
+
+  void publish_state(bool state) { this->state = state; }
+
+  bool state{false};
+
+ protected:
+  virtual void write_state(bool state) = 0;
+};
+
+}  // namespace switch_
+}  // namespace esphome
+
+#define SUB_SWITCH(name)                             \
+ protected:                                          \
+  esphome::switch_::Switch *name##_switch_{nullptr}; \
+                                                     \
+ public:                                             \
+  void set_##name##_switch(esphome::switch_::Switch *s) { this->name##_switch_ = s; }
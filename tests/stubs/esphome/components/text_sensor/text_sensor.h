@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+namespace esphome {
+namespace text_sensor {
+
+class TextSensor {
+ public:
+  void publish_state(const std::string &state) {
+    this->state = state;
+    this->publish_count++;
+  }
+
+  std::string state;
+  int publish_count{0};
+};
+
+}  // namespace text_sensor
+}  // namespace esphome
+
+#define SUB_TEXT_SENSOR(name)                                     \
+ protected:                                                       \
+  esphome::text_sensor::TextSensor *name##_text_sensor_{nullptr}; \
+                                                                  \
+ public:                                                          \
+  void set_##name##_text_sensor(esphome::text_sensor::TextSensor *sensor) { this->name##_text_sensor_ = sensor; }
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace uart {
+
+class UARTComponent {
+ public:
+  virtual ~UARTComponent() {}
+
+  virtual void write_array(const uint8_t *data, size_t len) = 0;
+  virtual bool read_array(uint8_t *data, size_t len) = 0;
+  virtual int available() = 0;
+  virtual void load_settings(bool dump_config) {}
+};
+
+class UARTDevice {
+ public:
+  void set_uart_parent(UARTComponent *parent) { this->parent_ = parent; }
+
+  void write_array(const uint8_t *data, size_t len) { this->parent_->write_array(data, len); }
+  bool read_array(uint8_t *data, size_t len) { return this->parent_->read_array(data, len); }
+  int available() { return this->parent_->available(); }
+
+ protected:
+  UARTComponent *parent_{nullptr};
+};
+
+}  // namespace uart
+}  // namespace esphome
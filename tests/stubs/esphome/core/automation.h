@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+template <typename... Ts>
+class Action {
+ public:
+  virtual ~Action() {}
+  virtual void play(Ts... x) = 0;
+};
+
+template <typename... Ts>
+class Trigger {
+ public:
+  // Automations are replaced by callbacks registered by the test
+  void add_callback(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+
+  void trigger(Ts... x) {
+    for (auto &callback : this->callbacks_)
+      callback(x...);
+  }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+class Component {
+ public:
+  virtual ~Component();
+
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+
+  void status_set_warning() { this->warning_ = true; }
+  void status_clear_warning() { this->warning_ = false; }
+  bool status_has_warning() const { return this->warning_; }
+
+ protected:
+  // Intervals run from testing::advance
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f);
+
+  bool warning_{false};
+};
+
+class PollingComponent : public Component {
+ public:
+  virtual void update() = 0;
+
+  void set_update_interval(uint32_t interval) { this->update_interval_ = interval; }
+  uint32_t get_update_interval() const { return this->update_interval_; }
+
+ protected:
+  uint32_t update_interval_{0};
+};
+
+namespace testing {
+
+// Advance simulated time, running any intervals which become due
+void advance(uint32_t ms);
+
+}  // namespace testing
+}  // namespace esphome
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+// Time is simulated, see testing::advance
+uint32_t millis();
+uint32_t micros();
+
+}  // namespace esphome
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+
+template <typename T>
+class Parented {
+ public:
+  void set_parent(T *parent) { this->parent_ = parent; }
+  T *get_parent() const { return this->parent_; }
+
+ protected:
+  T *parent_{nullptr};
+};
+
+template <typename T>
+class optional {
+ public:
+  optional() {}
+  optional(T value) : value_(value), has_value_(true) {}
+
+  bool has_value() const { return this->has_value_; }
+  const T &operator*() const { return this->value_; }
+
+ protected:
+  T value_{};
+  bool has_value_{false};
+};
+
+template <typename T>
+class CallbackManager;
+
+template <typename... Ts>
+class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+
+  void call(Ts... args) {
+    for (auto &callback : this->callbacks_)
+      callback(args...);
+  }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+std::string format_hex(const uint8_t *data, size_t length);
+
+}  // namespace esphome
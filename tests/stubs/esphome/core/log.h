@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+
+namespace esphome {
+namespace testing {
+
+// Log output is disabled unless WINIX_TEST_LOG is set in the environment
+bool log_enabled();
+
+// Number of warnings logged, enabled or not, for checks of log rate limits
+extern size_t warning_count;
+
+}  // namespace testing
+}  // namespace esphome
+
+#define ESPHOME_TEST_LOG(level, tag, format, ...)                 \
+  do {                                                            \
+    if (esphome::testing::log_enabled())                          \
+      printf("[%s][%s] " format "\n", level, tag, ##__VA_ARGS__); \
+  } while (0)
+
+#define ESP_LOGE(tag, ...) ESPHOME_TEST_LOG("E", tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...)                   \
+  do {                                       \
+    esphome::testing::warning_count++;       \
+    ESPHOME_TEST_LOG("W", tag, __VA_ARGS__); \
+  } while (0)
+#define ESP_LOGI(tag, ...) ESPHOME_TEST_LOG("I", tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESPHOME_TEST_LOG("D", tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESPHOME_TEST_LOG("V", tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESPHOME_TEST_LOG("C", tag, __VA_ARGS__)
+
+#define LOG_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_TEXT_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_BINARY_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_SWITCH(prefix, type, obj) (void) (obj)
+#define LOG_FAN(prefix, type, obj) (void) (obj)
+#define LOG_SELECT(prefix, type, obj) (void) (obj)
+#define LOG_NUMBER(prefix, type, obj) (void) (obj)
+#define LOG_UPDATE_INTERVAL(obj) (void) (obj)
+
+#define YESNO(b) ((b) ? "YES" : "NO")
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace esphome {
+
+// Preferences are kept in memory for the life of the process, so a new component instance sees
+// what an earlier one saved, as after a reboot
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() {}
+  ESPPreferenceObject(std::vector<uint8_t> *storage, size_t *save_count) : storage_(storage), save_count_(save_count) {}
+
+  template <typename T>
+  bool save(const T *src) {
+    if (this->storage_ == nullptr)
+      return false;
+
+    this->storage_->assign(reinterpret_cast<const uint8_t *>(src), reinterpret_cast<const uint8_t *>(src) + sizeof(T));
+    (*this->save_count_)++;
+    return true;
+  }
+
+  template <typename T>
+  bool load(T *dest) {
+    if (this->storage_ == nullptr || this->storage_->size() != sizeof(T))
+      return false;
+
+    memcpy(dest, this->storage_->data(), sizeof(T));
+    return true;
+  }
+
+ protected:
+  std::vector<uint8_t> *storage_{nullptr};
+  size_t *save_count_{nullptr};
+};
+
+class ESPPreferences {
+ public:
+  template <typename T>
+  ESPPreferenceObject make_preference(uint32_t type) {
+    return ESPPreferenceObject(&this->storage_[type], &this->save_count_);
+  }
+
+  void clear() {
+    this->storage_.clear();
+    this->save_count_ = 0;
+  }
+
+  // Number of saves since cleared, as a measure of flash writes
+  size_t get_save_count() const { return this->save_count_; }
+
+ protected:
+  std::map<uint32_t, std::vector<uint8_t>> storage_;
+  size_t save_count_{0};
+};
+
+extern ESPPreferences *global_preferences;
+
+}  // namespace esphome
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// Minimal test framework, tests register themselves and run from test_main.cpp
+namespace winix_test {
+
+struct TestCase {
+  const char *name;
+  void (*function)();
+};
+
+inline std::vector<TestCase> &test_cases() {
+  static std::vector<TestCase> cases;
+  return cases;
+}
+
+inline int &failure_count() {
+  static int failures = 0;
+  return failures;
+}
+
+struct Registrar {
+  Registrar(const char *name, void (*function)()) { test_cases().push_back({name, function}); }
+};
+
+}  // namespace winix_test
+
+#define TEST(name)                                            \
+  static void name();                                         \
+  static winix_test::Registrar name##_registrar(#name, name); \
+  static void name()
+
+#define CHECK(condition)                                                   \
+  do {                                                                     \
+    if (!(condition)) {                                                    \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      winix_test::failure_count()++;                                       \
+    }                                                                      \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                                        \
+  do {                                                                                    \
+    if (!((actual) == (expected))) {                                                      \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed\n", __FILE__, __LINE__, #actual, #expected); \
+      winix_test::failure_count()++;                                                      \
+    }                                                                                     \
+  } while (0)
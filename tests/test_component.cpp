@@ -0,0 +1,609 @@
+// Tests of the component against a simulated MCU
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "automation.h"
+#include "esphome/core/log.h"
+#include "purifier.h"
+#include "test.h"
+
+using namespace esphome::winix_c545;
+using esphome::winix_c545::testing::Purifier;
+
+namespace {
+
+// Number of A211 commands the MCU received
+size_t count_commands(const Purifier &purifier) {
+  size_t count = 0;
+  for (const auto &sentence : purifier.mcu.get_received()) {
+    if (sentence.compare(0, 13, "AWS_RECV:A211") == 0)
+      count++;
+  }
+  return count;
+}
+
+// Index of the first received sentence starting with a prefix, or the number of sentences if none
+size_t find_received(const Purifier &purifier, const std::string &prefix) {
+  const auto &received = purifier.mcu.get_received();
+  for (size_t i = 0; i < received.size(); i++) {
+    if (received[i].compare(0, prefix.size(), prefix) == 0)
+      return i;
+  }
+  return received.size();
+}
+
+// Report an AQI in a sensor update and give the component time to handle it
+void send_aqi(Purifier &purifier, int aqi) {
+  purifier.mcu.set_state("S08", std::to_string(aqi));
+  purifier.mcu.send_sensors();
+  purifier.run(50);
+}
+
+void set_speed(Purifier &purifier, int speed) {
+  esphome::fan::FanCall call;
+  call.set_speed(speed);
+  purifier.fan.perform(call);
+}
+
+}  // namespace
+
+TEST(handshake_connects_and_publishes_state) {
+  Purifier purifier;
+  purifier.start();
+
+  CHECK(purifier.mcu.is_connected());
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 1u);
+  CHECK_EQ(purifier.mcu.count_received("MCU_READY:OK"), 1u);
+  CHECK_EQ(purifier.mcu.count_received("MIB:OK 7595"), 1u);
+  CHECK_EQ(purifier.mcu.count_received("AWS_IND:CONNECT OK"), 1u);
+  CHECK_EQ(purifier.mcu.count_received("AWS_SEND:OK"), 2u);
+  CHECK_EQ(purifier.mcu.get_malformed_count(), 0u);
+
+  CHECK(purifier.fan.state);
+  CHECK_EQ(purifier.fan.speed, 1);
+  CHECK_EQ(purifier.aqi.state, 50.0f);
+  CHECK_EQ(purifier.light.state, 30.0f);
+  CHECK_EQ(purifier.filter_age.state, 1000.0f);
+  CHECK_EQ(purifier.filter_lifetime.state, 6480.0f);
+}
+
+TEST(handshake_backs_off_while_mcu_is_silent) {
+  Purifier purifier;
+  purifier.mcu.set_silent(true);
+  purifier.component.setup();
+
+  // DEVICEREADY waits 5s for a reply, then the restart is delayed 3s doubled per failure
+  purifier.run(10900);
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 1u);
+  purifier.run(200);
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 2u);
+
+  // The reply timeout doubles too, 10s then a restart delay of 12s
+  purifier.run(21800);
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 2u);
+  purifier.run(200);
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 3u);
+}
+
+TEST(resume_waits_for_state_then_connects) {
+  Purifier().start();
+  const size_t saves = esphome::global_preferences->get_save_count();
+
+  // After a reboot the MCU is still connected and sends state without a handshake
+  Purifier purifier;
+  purifier.component.setup();
+  purifier.run(1000);
+  purifier.mcu.send_state();
+  purifier.run(100);
+
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 0u);
+  CHECK_EQ(purifier.fan.speed, 1);
+  purifier.run(5000);
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 0u);
+
+  // Still connected, so nothing is written
+  CHECK_EQ(esphome::global_preferences->get_save_count(), saves);
+}
+
+TEST(resume_falls_back_to_handshake_after_timeout) {
+  Purifier().start();
+
+  Purifier purifier;
+  purifier.component.setup();
+  purifier.run(2900);
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 0u);
+
+  purifier.run(1000);
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 1u);
+  CHECK(purifier.mcu.is_connected());
+}
+
+TEST(resume_restarts_handshake_when_mcu_restarts) {
+  Purifier().start();
+
+  // The MCU restarted too and announces it
+  Purifier purifier;
+  purifier.component.setup();
+  purifier.mcu.send("DEVICEREADY");
+  purifier.run(200);
+
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 1u);
+  CHECK(purifier.mcu.is_connected());
+}
+
+TEST(unchanged_payloads_are_not_published_again) {
+  Purifier purifier;
+  purifier.start();
+
+  const int publishes = purifier.aqi.publish_count;
+  purifier.mcu.send_sensors();
+  purifier.run(100);
+  CHECK_EQ(purifier.aqi.publish_count, publishes);
+
+  purifier.mcu.set_state("S08", "75");
+  purifier.mcu.send_sensors();
+  purifier.run(100);
+  CHECK_EQ(purifier.aqi.publish_count, publishes + 1);
+  CHECK_EQ(purifier.aqi.state, 75.0f);
+}
+
+TEST(repeated_payload_is_applied_after_another_code_changed_its_keys) {
+  Purifier purifier;
+  purifier.start();
+
+  purifier.mcu.set_state("S08", "75");
+  purifier.mcu.send_sensors();
+  purifier.run(100);
+  CHECK_EQ(purifier.aqi.state, 75.0f);
+
+  // A210 also carries the AQI
+  purifier.mcu.set_state("S08", "60");
+  purifier.mcu.send_state();
+  purifier.run(100);
+  CHECK_EQ(purifier.aqi.state, 60.0f);
+
+  // Same A220 payload as before, but it changes the AQI again
+  purifier.mcu.set_state("S08", "75");
+  purifier.mcu.send_sensors();
+  purifier.run(100);
+  CHECK_EQ(purifier.aqi.state, 75.0f);
+}
+
+TEST(aqi_publishes_are_limited_by_interval_and_delta) {
+  Purifier purifier;
+  purifier.component.set_aqi_publish_policy(5000, 0, 5, 0);
+  purifier.start();
+  CHECK_EQ(purifier.aqi.state, 50.0f);
+
+  // Deferred until the minimum interval has passed since the first publish, checked each second
+  send_aqi(purifier, 60);
+  CHECK_EQ(purifier.aqi.state, 50.0f);
+  purifier.run(3000);
+  CHECK_EQ(purifier.aqi.state, 50.0f);
+  purifier.run(3000);
+  CHECK_EQ(purifier.aqi.state, 60.0f);
+
+  // Changes smaller than the delta are not published, however long they last
+  const int publishes = purifier.aqi.publish_count;
+  send_aqi(purifier, 64);
+  purifier.run(10000);
+  CHECK_EQ(purifier.aqi.state, 60.0f);
+  CHECK_EQ(purifier.aqi.publish_count, publishes);
+
+  send_aqi(purifier, 65);
+  purifier.run(1000);
+  CHECK_EQ(purifier.aqi.state, 65.0f);
+  CHECK_EQ(purifier.aqi.publish_count, publishes + 1);
+}
+
+TEST(aqi_heartbeat_republishes_unchanged_value) {
+  Purifier purifier;
+  purifier.component.set_aqi_publish_policy(0, 10000, 0, 0);
+  purifier.start();
+  const int publishes = purifier.aqi.publish_count;
+
+  purifier.run(5000);
+  CHECK_EQ(purifier.aqi.publish_count, publishes);
+  purifier.run(6000);
+  CHECK_EQ(purifier.aqi.publish_count, publishes + 1);
+  CHECK_EQ(purifier.aqi.state, 50.0f);
+}
+
+TEST(aqi_statistics_cover_the_sample_window) {
+  esphome::sensor::Sensor mean, min, max, ema, rate;
+  Purifier purifier;
+  purifier.component.set_aqi_statistics(2000, 4, 0.5f);
+  purifier.component.set_aqi_statistics_sensors(&mean, &min, &max, &ema, &rate);
+  purifier.start();
+
+  // Follow a sample, so each new value is sampled once by the next one
+  int samples = mean.publish_count;
+  CHECK(purifier.run_until([&]() { return mean.publish_count > samples; }, 2100));
+  for (int aqi : {10, 20, 30, 40}) {
+    samples = mean.publish_count;
+    send_aqi(purifier, aqi);
+    CHECK(purifier.run_until([&]() { return mean.publish_count > samples; }, 2100));
+  }
+
+  // Only the last four samples are in the window
+  CHECK_EQ(mean.state, 25.0f);
+  CHECK_EQ(min.state, 10.0f);
+  CHECK_EQ(max.state, 40.0f);
+
+  // The EMA started from the earlier samples of 50
+  CHECK_EQ(ema.state, 33.75f);
+
+  // 10 per sample every 2s is 300 per minute
+  CHECK_EQ(rate.state, 300.0f);
+}
+
+TEST(filter_remaining_and_eta_follow_usage) {
+  esphome::sensor::Sensor remaining, eta;
+  Purifier purifier;
+  purifier.component.set_filter_remaining_sensor(&remaining);
+  purifier.component.set_filter_eta_sensor(&eta);
+  purifier.start();
+
+  // 5480 of 6480 hours left. No ETA until the usage rate is known
+  CHECK_EQ(remaining.state, 85.0f);
+  CHECK(std::isnan(eta.state));
+
+  // The first increment may follow a partial hour, so it only starts timing
+  const auto report_age = [&](uint32_t wait, const char *age) {
+    esphome::testing::advance(wait);
+    purifier.mcu.set_state("A21", age);
+    purifier.mcu.send_state();
+    purifier.run(100);
+  };
+  report_age(1000, "1001");
+  CHECK(std::isnan(eta.state));
+
+  // Running all the time, one hour of age per hour
+  report_age(3600000, "1002");
+  CHECK_EQ(eta.state, 5478.0f);
+
+  // Usage halves, the rate is smoothed to 0.85
+  report_age(7200000, "1003");
+  CHECK_EQ(eta.state, 6444.0f);
+
+  // Unchanged percentage is not published again
+  CHECK_EQ(remaining.state, 85.0f);
+  CHECK_EQ(remaining.publish_count, 1);
+}
+
+TEST(command_is_sent_and_confirmed) {
+  Purifier purifier;
+  purifier.start();
+  purifier.mcu.clear_received();
+
+  set_speed(purifier, 3);
+  purifier.run(3000);
+
+  CHECK_EQ(purifier.mcu.count_received("AWS_RECV:A211 12 {\"A04\":\"3\"}"), 1u);
+  CHECK_EQ(purifier.mcu.get_state("A04"), "3");
+  CHECK_EQ(purifier.fan.speed, 3);
+}
+
+TEST(commands_within_the_coalesce_window_are_merged) {
+  Purifier purifier;
+  purifier.start();
+  purifier.mcu.clear_received();
+
+  set_speed(purifier, 2);
+  purifier.run(16);
+  set_speed(purifier, 3);
+  WinixStateMap states;
+  states.set(StateKey::Plasmawave, 0);
+  purifier.component.write_state(states);
+  purifier.run(3000);
+
+  CHECK_EQ(count_commands(purifier), 1u);
+  CHECK_EQ(purifier.mcu.count_received("AWS_RECV:A211 12 {\"A04\":\"3\",\"A07\":\"0\"}"), 1u);
+}
+
+TEST(unacknowledged_command_is_retried_then_reverted) {
+  Purifier purifier;
+  purifier.start();
+  purifier.mcu.clear_received();
+  purifier.mcu.set_apply_commands(false);
+
+  set_speed(purifier, 3);
+  purifier.run(100);
+  CHECK_EQ(purifier.fan.speed, 3);
+
+  // Timeouts back off from 1s, the default two retries complete within 7s
+  purifier.run(8000);
+  CHECK_EQ(count_commands(purifier), 3u);
+  CHECK_EQ(purifier.fan.speed, 1);
+  CHECK_EQ(purifier.mcu.get_state("A04"), "1");
+}
+
+TEST(failed_command_for_unreported_key_requests_refresh) {
+  Purifier purifier;
+  purifier.mcu.erase_state("A04");
+  purifier.start();
+  purifier.mcu.set_apply_commands(false);
+
+  // The MCU has a speed, but has not reported it yet
+  purifier.mcu.set_state("A04", "1");
+  purifier.mcu.clear_received();
+
+  set_speed(purifier, 3);
+  purifier.run(8000);
+  CHECK_EQ(count_commands(purifier), 3u);
+
+  // Nothing to revert to, so the state is requested instead of keeping the rejected speed
+  CHECK_EQ(purifier.mcu.count_received("AWS_IND:CONNECT OK"), 1u);
+  CHECK_EQ(purifier.fan.speed, 1);
+}
+
+TEST(command_is_dropped_when_changed_on_device) {
+  Purifier purifier;
+  purifier.start();
+  purifier.mcu.clear_received();
+  purifier.mcu.set_apply_commands(false);
+
+  set_speed(purifier, 3);
+  purifier.run(100);
+
+  // Speed button pressed on the purifier before the command was applied
+  purifier.mcu.set_state("A04", "2");
+  purifier.mcu.send_state();
+  purifier.run(8000);
+
+  // Not retried over the change
+  CHECK_EQ(count_commands(purifier), 1u);
+  CHECK_EQ(purifier.fan.speed, 2);
+  CHECK_EQ(purifier.mcu.get_state("A04"), "2");
+}
+
+TEST(select_and_number_write_their_keys) {
+  Purifier purifier;
+  WinixC545Select select;
+  select.traits.set_options({"Low", "High"});
+  select.add_value(1);
+  select.add_value(2);
+  select.set_parent(&purifier.component);
+  purifier.component.add_key_entity("A05", &select);
+
+  WinixC545Number number;
+  number.set_parent(&purifier.component);
+  purifier.component.add_key_entity("B01", &number);
+
+  // Room for the extra key in state updates
+  purifier.component.set_max_line_length(256);
+  purifier.start();
+  CHECK_EQ(select.state, "Low");
+  CHECK(std::isnan(number.state));
+
+  // Written to the MCU and confirmed by its state update
+  purifier.mcu.clear_received();
+  select.make_call("High");
+  number.make_call(42.4f);
+  purifier.run(200);
+  CHECK_EQ(purifier.mcu.count_received("AWS_RECV:A211 12 {\"A05\":\"2\",\"B01\":\"42\"}"), 1u);
+  CHECK_EQ(purifier.mcu.get_state("A05"), "2");
+  CHECK_EQ(select.state, "High");
+
+  // Rounded when written, the confirmed value replaces the optimistic one
+  CHECK_EQ(number.state, 42.0f);
+
+  // Confirmed, so not retried
+  purifier.run(3000);
+  CHECK_EQ(count_commands(purifier), 1u);
+
+  // Changes reported by the MCU are published
+  purifier.mcu.set_state("A05", "1");
+  purifier.mcu.set_state("B01", "7");
+  purifier.mcu.send_state();
+  purifier.run(100);
+  CHECK_EQ(select.state, "Low");
+  CHECK_EQ(number.state, 7.0f);
+}
+
+TEST(select_warns_once_for_value_without_option) {
+  Purifier purifier;
+  WinixC545Select select;
+  select.traits.set_options({"Low", "High"});
+  select.add_value(1);
+  select.add_value(2);
+  select.set_parent(&purifier.component);
+  purifier.component.add_key_entity("A05", &select);
+
+  const size_t warnings = esphome::testing::warning_count;
+  select.update_value(7);
+  select.update_value(7);
+  CHECK_EQ(esphome::testing::warning_count, warnings + 1);
+
+  // A matched value in between warns again for the next unmatched one
+  select.update_value(1);
+  CHECK_EQ(select.state, "Low");
+  select.update_value(7);
+  CHECK_EQ(esphome::testing::warning_count, warnings + 2);
+}
+
+TEST(write_keys_action_sends_one_command) {
+  Purifier purifier;
+  purifier.start();
+  purifier.mcu.clear_received();
+
+  WriteKeysAction<> action;
+  action.set_parent(&purifier.component);
+  action.add_key("A04", 3);
+  action.add_key("A07", 0);
+  action.play();
+  purifier.run(200);
+
+  CHECK_EQ(count_commands(purifier), 1u);
+  CHECK_EQ(purifier.mcu.count_received("AWS_RECV:A211 12 {\"A04\":\"3\",\"A07\":\"0\"}"), 1u);
+  CHECK_EQ(purifier.mcu.get_state("A07"), "0");
+  CHECK_EQ(purifier.fan.speed, 3);
+}
+
+TEST(acknowledgements_are_sent_before_paced_commands) {
+  Purifier purifier;
+  purifier.component.set_command_coalesce_window(0);
+  purifier.start();
+  purifier.mcu.clear_received();
+
+  // Command and a sensor update arrive together, the reply goes first
+  set_speed(purifier, 3);
+  purifier.mcu.send_sensors();
+
+  uint32_t elapsed = 0;
+  while (count_commands(purifier) == 0 && elapsed < 100) {
+    purifier.step(1);
+    elapsed++;
+  }
+
+  const size_t ack = find_received(purifier, "AWS_SEND:OK");
+  const size_t command = find_received(purifier, "AWS_RECV:A211");
+  CHECK(ack < command);
+
+  // The command waits for the TX interval after the reply
+  CHECK(elapsed >= 20);
+}
+
+TEST(replayed_lines_do_not_change_live_state) {
+  Purifier purifier;
+  purifier.component.set_capture_buffer_size(2048);
+  purifier.component.set_max_line_length(512);
+  purifier.start();
+
+  // Captured lines are truncated to 255 bytes, so this update is lost from the capture and the
+  // replay ends with the AQI of 50 from the handshake
+  for (int i = 0; i < 20; i++)
+    purifier.mcu.set_state("X" + std::to_string(10 + i), "0");
+  purifier.mcu.set_state("S08", "80");
+  purifier.mcu.send_state();
+  purifier.run(100);
+  CHECK_EQ(purifier.aqi.state, 80.0f);
+
+  purifier.mcu.clear_received();
+  const int aqi_publishes = purifier.aqi.publish_count;
+  const int fan_publishes = purifier.fan.publish_count;
+  purifier.component.replay_capture();
+
+  // A live sentence without states runs the loop, which would publish any states changed by the replay
+  purifier.mcu.send("SETMIB=18 C545");
+  purifier.run(2000);
+
+  CHECK_EQ(purifier.mcu.get_received().size(), 1u);
+  CHECK_EQ(purifier.aqi.state, 80.0f);
+  CHECK_EQ(purifier.aqi.publish_count, aqi_publishes);
+  CHECK_EQ(purifier.fan.publish_count, fan_publishes);
+  CHECK(purifier.link.state);
+
+  // Live updates are still decoded after the replay
+  purifier.mcu.set_state("S08", "50");
+  purifier.mcu.send_sensors();
+  purifier.run(100);
+  CHECK_EQ(purifier.aqi.state, 50.0f);
+}
+
+namespace {
+
+// Command a speed and let it be saved for restore
+void save_speed(int speed) {
+  Purifier purifier;
+  purifier.component.set_restore_save_delay(0);
+  purifier.start();
+  set_speed(purifier, speed);
+  purifier.run(3000);
+  CHECK_EQ(purifier.mcu.get_state("A04"), std::to_string(speed));
+}
+
+}  // namespace
+
+TEST(restored_commands_matching_mcu_are_not_sent) {
+  save_speed(3);
+
+  // Reboot while the MCU keeps running at the restored speed
+  Purifier purifier;
+  purifier.component.set_apply_restored_state(true);
+  purifier.mcu.set_state("A04", "3");
+  purifier.start(10000);
+  purifier.run(3000);
+
+  CHECK_EQ(count_commands(purifier), 0u);
+  CHECK_EQ(purifier.fan.speed, 3);
+}
+
+TEST(restored_commands_replay_after_first_state_update) {
+  save_speed(3);
+
+  // Reboot alongside the MCU, which comes back at low speed
+  Purifier purifier;
+  purifier.component.set_apply_restored_state(true);
+  purifier.component.add_aqi_control_threshold(100);
+  purifier.component.add_aqi_control_threshold(200);
+  purifier.component.add_aqi_control_threshold(300);
+  purifier.component.set_aqi_control_min_dwell(0);
+  purifier.start(10000);
+
+  // The restored speed is only sent once the MCU reported its state
+  const size_t state_ack = find_received(purifier, "AWS_SEND:OK");
+  const size_t command = find_received(purifier, "AWS_RECV:A211 12 {\"A04\":\"3\"}");
+  CHECK(command < purifier.mcu.get_received().size());
+  CHECK(state_ack < command);
+
+  // Replaying is not a manual change, so AQI control takes over and lowers the speed for the low AQI
+  purifier.run(5000);
+  CHECK_EQ(purifier.mcu.count_received("AWS_RECV:A211 12 {\"A04\":\"1\"}"), 1u);
+  CHECK_EQ(purifier.mcu.get_state("A04"), "1");
+}
+
+TEST(link_watchdog_recovers_silent_mcu) {
+  Purifier purifier;
+  purifier.component.set_link_timeout(3000);
+  purifier.start();
+  CHECK(purifier.link.state);
+
+  purifier.mcu.set_silent(true);
+  purifier.run(4500);
+  CHECK(!purifier.link.state);
+  CHECK_EQ(purifier.mcu.count_received("DEVICEREADY"), 2u);
+  CHECK_EQ(purifier.uart.get_reload_count(), 0u);
+
+  // Still silent after the handshake was restarted, the UART is reinitialized
+  purifier.run(3500);
+  CHECK_EQ(purifier.uart.get_reload_count(), 1u);
+
+  purifier.mcu.set_silent(false);
+  CHECK(purifier.run_until([&purifier]() { return purifier.link.state && purifier.mcu.is_connected(); }, 70000));
+}
+
+TEST(command_with_every_writable_key_fits) {
+  Purifier purifier;
+  purifier.component.set_max_line_length(512);
+
+  std::vector<std::unique_ptr<WinixC545CustomSwitch>> switches;
+  WinixStateMap states;
+  states.set(StateKey::Power, 65535);
+  states.set(StateKey::Auto, 65535);
+  states.set(StateKey::Speed, 65535);
+  states.set(StateKey::Plasmawave, 65535);
+  for (size_t i = 0; i < MAX_CUSTOM_KEYS; i++) {
+    const std::string name = "B" + std::string(i < 10 ? "0" : "") + std::to_string(i);
+    switches.emplace_back(new WinixC545CustomSwitch());
+    switches.back()->set_parent(&purifier.component);
+    purifier.component.add_custom_switch(name.c_str(), switches.back().get());
+    CHECK(purifier.component.set_key_state(states, name.c_str(), 65535));
+  }
+
+  purifier.start();
+  purifier.mcu.clear_received();
+  purifier.component.write_state(states);
+  purifier.run(3000);
+
+  // Sent once in full and confirmed by the MCU
+  CHECK_EQ(count_commands(purifier), 1u);
+  const size_t command = find_received(purifier, "AWS_RECV:A211");
+  if (command < purifier.mcu.get_received().size())
+    CHECK_EQ(purifier.mcu.get_received()[command].size(), sizeof("AWS_RECV:A211 12 {") - 1 + 20 * (sizeof("\"A02\":\"65535\",") - 1));
+  CHECK_EQ(purifier.mcu.get_state("B15"), "65535");
+  CHECK_EQ(purifier.mcu.get_state("A02"), "65535");
+}
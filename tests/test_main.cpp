@@ -0,0 +1,27 @@
+#include <cstdio>
+#include <cstring>
+
+#include "esphome/core/preferences.h"
+#include "test.h"
+
+int main(int argc, char **argv) {
+  // Optionally run only the tests whose name contains the first argument
+  const char *filter = argc > 1 ? argv[1] : nullptr;
+
+  int run = 0;
+  for (const auto &test : winix_test::test_cases()) {
+    if (filter != nullptr && strstr(test.name, filter) == nullptr)
+      continue;
+
+    // Each test starts on a freshly flashed device, preferences only persist within a test
+    esphome::global_preferences->clear();
+
+    const int failures = winix_test::failure_count();
+    test.function();
+    printf("%s %s\n", winix_test::failure_count() == failures ? "PASS" : "FAIL", test.name);
+    run++;
+  }
+
+  printf("%d tests, %d failed checks\n", run, winix_test::failure_count());
+  return winix_test::failure_count() == 0 ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+// Properties of the receive path which must hold for any input
+
+#include <string>
+#include <vector>
+
+#include "purifier.h"
+#include "test.h"
+
+using namespace esphome::winix_c545;
+using esphome::winix_c545::testing::Purifier;
+
+namespace {
+
+const std::string STREAM =
+    "AT*ICT*AWS_SEND=A210 {\"A02\":\"1\",\"A03\":\"0\",\"A04\":\"3\",\"A05\":\"01\",\"A07\":\"0\",\"A21\":\"2000\",\"S07\":\"02\",\"S08\":\"120\",\"S14\":\"60\"}\r\n"
+    "garbage\r\n"
+    "AT*ICT*AWS_SEND=A220 {\"S07\":\"03\",\"S08\":\"250\",\"S14\":\"61\"}\r\n"
+    "AT*ICT*AWS_SEND=A240 {\"P01\":\"4000\"}\r\n";
+
+// Values published by the entities, and the bytes sent in reply
+struct Outcome {
+  float aqi;
+  float light;
+  float filter_age;
+  float filter_lifetime;
+  int speed;
+  bool state;
+  std::string tx;
+
+  bool operator==(const Outcome &other) const {
+    return this->aqi == other.aqi && this->light == other.light && this->filter_age == other.filter_age && this->filter_lifetime == other.filter_lifetime && this->speed == other.speed &&
+           this->state == other.state && this->tx == other.tx;
+  }
+};
+
+// Feed a connected component the stream in chunks ending at the given offsets
+Outcome feed(const std::vector<size_t> &splits) {
+  Purifier purifier;
+  purifier.start();
+  purifier.uart.take_tx();
+
+  size_t start = 0;
+  for (size_t i = 0; i <= splits.size(); i++) {
+    const size_t end = i < splits.size() ? splits[i] : STREAM.size();
+    purifier.uart.inject(STREAM.substr(start, end - start));
+    purifier.step(1);
+    start = end;
+  }
+  purifier.run(100);
+
+  return {purifier.aqi.state, purifier.light.state, purifier.filter_age.state, purifier.filter_lifetime.state, purifier.fan.speed, purifier.fan.state, purifier.uart.take_tx()};
+}
+
+}  // namespace
+
+TEST(split_feeds_match_single_feed) {
+  const Outcome single = feed({});
+  CHECK_EQ(single.aqi, 250.0f);
+  CHECK_EQ(single.filter_lifetime, 4000.0f);
+
+  for (size_t split = 1; split < STREAM.size(); split++)
+    CHECK(feed({split}) == single);
+
+  // Byte at a time, so the stream parser resumes at every position
+  std::vector<size_t> splits;
+  for (size_t split = 1; split < STREAM.size(); split++)
+    splits.push_back(split);
+  CHECK(feed(splits) == single);
+}
+
+TEST(payloads_apply_all_or_nothing) {
+  Purifier purifier;
+  purifier.component.set_max_line_length(256);
+  purifier.start();
+
+  const std::string line = "AT*ICT*AWS_SEND=A210 {\"A02\":\"1\",\"A03\":\"0\",\"A04\":\"3\",\"A07\":\"0\",\"A21\":\"2000\",\"S07\":\"02\",\"S08\":\"120\",\"S14\":\"60\"}";
+  const std::string corruptions[] = {"", "x", "\"", ",", ":", "}", "{", "99999", "\"A99\":\"1\""};
+
+  // Corrupt the line at every position. Any line which is not acknowledged must leave the published states at
+  // those of the handshake, any accepted line must apply every key it contains
+  for (size_t position = 22; position < line.size(); position++) {
+    for (const auto &corruption : corruptions) {
+      purifier.mcu.clear_received();
+      const std::string corrupted = line.substr(0, position) + corruption + line.substr(position + 1);
+      purifier.uart.inject(corrupted + "\r\n");
+      purifier.run(32);
+
+      const bool acked = purifier.mcu.count_received("AWS_SEND:OK") != 0;
+      if (!acked) {
+        CHECK_EQ(purifier.aqi.state, 50.0f);
+        CHECK_EQ(purifier.light.state, 30.0f);
+        CHECK_EQ(purifier.fan.speed, 1);
+      } else if (corrupted.find("\"S14\":\"60\"}") != std::string::npos && corrupted.find("\"A04\":\"3\"") != std::string::npos) {
+        CHECK_EQ(purifier.light.state, 60.0f);
+        CHECK_EQ(purifier.fan.speed, 3);
+      }
+
+      // Restore the handshake states
+      purifier.mcu.send_state();
+      purifier.run(32);
+    }
+  }
+}
@@ -0,0 +1,154 @@
+// Unit tests of the host-buildable protocol classes
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+#include "test.h"
+
+using namespace esphome::winix_c545;
+
+namespace {
+
+// Feed a whole line, returns true if it completed a sentence
+bool feed(WinixStreamParser &parser, const std::string &data) {
+  return parser.feed(reinterpret_cast<const uint8_t *>(data.data()), data.size()) != 0 && parser.complete();
+}
+
+}  // namespace
+
+TEST(parser_recognises_command_and_arguments) {
+  WinixStreamParser parser;
+  CHECK(feed(parser, "AT*ICT*AWS_SEND=A220 {\"S08\":\"50\"}\r"));
+  CHECK(parser.type() == SentenceType::AwsSend);
+  CHECK_EQ(std::string(parser.arguments()), "=A220 {\"S08\":\"50\"}");
+
+  CHECK(feed(parser, "\nAT*ICT*MIB=32\r"));
+  CHECK(parser.type() == SentenceType::MIB);
+  CHECK_EQ(std::string(parser.arguments()), "=32");
+
+  CHECK(feed(parser, "garbage\r"));
+  CHECK(parser.type() == SentenceType::Invalid);
+  CHECK_EQ(std::string(parser.line()), "garbage");
+}
+
+TEST(parser_discards_overflowing_lines) {
+  WinixStreamParser parser;
+  const std::string line = "AT*ICT*AWS_SEND=A210 {" + std::string(WinixStreamParser::DEFAULT_MAX_LINE_LENGTH, 'x') + "}\r";
+  const std::string next = "AT*ICT*MCU_READY=1.2.0\r";
+
+  // The long line is dropped without completing, the following line is intact
+  const std::string data = line + next;
+  const size_t consumed = parser.feed(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+  CHECK_EQ(consumed, data.size());
+  CHECK(parser.complete());
+  CHECK(parser.type() == SentenceType::McuReady);
+  CHECK_EQ(parser.get_overflow_count(), 1u);
+}
+
+TEST(state_map_iterates_in_key_order) {
+  WinixStateMap states;
+  states.set(StateKey::Light, 30);
+  states.set(StateKey::Power, 1);
+  CHECK(!states.emplace(StateKey::Power, 0));
+  CHECK(states.emplace(StateKey::Speed, 3));
+
+  std::vector<StateKey> keys;
+  for (const auto state : states)
+    keys.push_back(state.key);
+
+  CHECK_EQ(keys.size(), 3u);
+  CHECK(keys[0] == StateKey::Power);
+  CHECK(keys[1] == StateKey::Speed);
+  CHECK(keys[2] == StateKey::Light);
+  CHECK_EQ(states.get(StateKey::Power), 1);
+
+  states.erase(StateKey::Speed);
+  CHECK(!states.has(StateKey::Speed));
+  CHECK_EQ(states.size(), 2u);
+}
+
+TEST(tx_queue_orders_by_priority_then_age) {
+  WinixTxQueue queue;
+  queue.push(TxPriority::Refresh, "refresh");
+  queue.push(TxPriority::Command, nullptr);
+  queue.push(TxPriority::Protocol, "first");
+  queue.push(TxPriority::Protocol, "second");
+
+  CHECK(queue.contains(TxPriority::Command));
+  CHECK(queue.front().priority == TxPriority::Protocol);
+  CHECK_EQ(std::string(queue.front().sentence), "first");
+  queue.pop();
+  CHECK_EQ(std::string(queue.front().sentence), "second");
+  queue.pop();
+  CHECK(queue.front().priority == TxPriority::Command);
+  queue.pop();
+  CHECK_EQ(std::string(queue.front().sentence), "refresh");
+  queue.pop();
+  CHECK(queue.empty());
+
+  for (size_t i = 0; i < WinixTxQueue::CAPACITY; i++)
+    CHECK(queue.push(TxPriority::Protocol, "ack"));
+  CHECK(!queue.push(TxPriority::Protocol, "ack"));
+}
+
+TEST(capture_buffer_evicts_oldest_lines) {
+  uint8_t storage[64];
+  WinixCaptureBuffer capture;
+  capture.set_storage(storage, sizeof(storage));
+
+  // Each record is a header plus the line, only the newest fit
+  for (int i = 0; i < 10; i++) {
+    const std::string line = "line " + std::to_string(i);
+    capture.push(WinixCaptureBuffer::Direction::RX, i, line.data(), line.size());
+  }
+
+  std::vector<std::string> lines;
+  capture.for_each([&lines](const WinixCaptureBuffer::Header &header, const char *line) { lines.emplace_back(line, header.length); });
+
+  CHECK(!lines.empty());
+  CHECK_EQ(lines.size(), capture.size());
+  CHECK_EQ(lines.back(), "line 9");
+  CHECK(lines.front() != "line 0");
+}
+
+TEST(telemetry_frame_layout) {
+  WinixStateMap states;
+  states.set(StateKey::Power, 1);
+  states.set(StateKey::AQI, 0x1234);
+
+  uint8_t frame[TELEMETRY_FRAME_SIZE];
+  CHECK_EQ(encode_telemetry_frame(frame, states, 0x0102, 0x03040506, TELEMETRY_FLAG_CONNECTED), TELEMETRY_FRAME_SIZE);
+
+  // Header is version, flags, sequence, timestamp and key mask, little-endian
+  CHECK_EQ(frame[0], TELEMETRY_FRAME_VERSION);
+  CHECK_EQ(frame[1], TELEMETRY_FLAG_CONNECTED);
+  CHECK_EQ(frame[2], 0x02);
+  CHECK_EQ(frame[3], 0x01);
+  CHECK_EQ(frame[4], 0x06);
+  CHECK_EQ(frame[7], 0x03);
+
+  const uint32_t mask = frame[8] | frame[9] << 8 | frame[10] << 16 | uint32_t(frame[11]) << 24;
+  CHECK_EQ(mask, (1u << static_cast<size_t>(StateKey::Power)) | (1u << static_cast<size_t>(StateKey::AQI)));
+
+  const size_t aqi = TELEMETRY_HEADER_SIZE + 2 * static_cast<size_t>(StateKey::AQI);
+  CHECK_EQ(frame[aqi], 0x34);
+  CHECK_EQ(frame[aqi + 1], 0x12);
+}
+
+TEST(speed_controller_applies_hysteresis) {
+  WinixSpeedController controller;
+  controller.add_threshold(100);
+  controller.add_threshold(200);
+  controller.set_hysteresis(10);
+
+  CHECK_EQ(controller.target_level(50, 1), 1);
+  CHECK_EQ(controller.target_level(150, 1), 2);
+  CHECK_EQ(controller.target_level(95, 2), 2);
+  CHECK_EQ(controller.target_level(85, 2), 1);
+  CHECK_EQ(controller.target_level(250, 1), 3);
+
+  CHECK_EQ(WinixSpeedController::level_from_value(5), 4);
+  CHECK_EQ(WinixSpeedController::level_from_value(6), 0);
+}